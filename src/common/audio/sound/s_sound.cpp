@@ -131,6 +131,13 @@ void SoundEngine::CacheMarkedSounds()
 		MarkUsed(chan->SoundID);
 	}
 
+	for (unsigned i = 1; i < S_sfx.Size(); ++i)
+	{
+		if (S_sfx[i].bUsed && !S_sfx[i].data.isValid() && S_sfx[i].lumpnum >= 0)
+		{
+			PrefetchSound(S_sfx[i].lumpnum);
+		}
+	}
 	for (unsigned i = 1; i < S_sfx.Size(); ++i)
 	{
 		if (S_sfx[i].bUsed)
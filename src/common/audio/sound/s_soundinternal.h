@@ -261,6 +261,7 @@ private:
 	// Checks if a copy of this sound is already playing.
 	bool CheckSingular(int sound_id);
 	virtual TArray<uint8_t> ReadSound(int lumpnum) = 0;
+	virtual void PrefetchSound(int lumpnum) {}	// lets the client start reading the sound's data in the background before ReadSound is called.
 protected:
 	virtual bool CheckSoundLimit(sfxinfo_t* sfx, const FVector3& pos, int near_limit, float limit_range, int sourcetype, const void* actor, int channel);
 	virtual FSoundID ResolveSound(const void *ent, int srctype, FSoundID soundid, float &attenuation);
@@ -52,6 +52,8 @@
 #include "version.h"
 #include "findfile.h"
 #include "md5.h"
+#include "i_time.h"
+#include "tflatmap.h"
 
 extern FILE* Logfile;
 
@@ -336,3 +338,81 @@ CCMD(printlocalized)
 	}
 
 }
+
+//==========================================================================
+//
+// CCMD mapbench
+//
+// Compares TMap and TFlatMap on the kinds of keys the engine uses.
+// The names come from the name table, the strings are their text and
+// the pointers are separately allocated blocks.
+//
+//==========================================================================
+
+template<class MapType, class KT>
+static void BenchMap(const char *label, const TArray<KT> &keys, const TArray<KT> &misses, int repeat)
+{
+	uint64_t inserttime = 0, hittime = 0, misstime = 0, itertime = 0;
+	int found = 0;
+
+	for (int r = 0; r < repeat; r++)
+	{
+		MapType map;
+		uint64_t start = I_nsTime();
+		for (unsigned i = 0; i < keys.Size(); i++) map.Insert(keys[i], i);
+		uint64_t t1 = I_nsTime();
+		for (unsigned i = 0; i < keys.Size(); i++) found += map.CheckKey(keys[i]) != nullptr;
+		uint64_t t2 = I_nsTime();
+		for (unsigned i = 0; i < misses.Size(); i++) found += map.CheckKey(misses[i]) != nullptr;
+		uint64_t t3 = I_nsTime();
+		typename MapType::Iterator it(map);
+		typename MapType::Pair *pair;
+		while (it.NextPair(pair)) found += pair->Value & 1;
+		uint64_t t4 = I_nsTime();
+
+		inserttime += t1 - start;
+		hittime += t2 - t1;
+		misstime += t3 - t2;
+		itertime += t4 - t3;
+	}
+	double div = 1e6 * repeat;
+	Printf("%-20s insert %8.3f ms, hit %8.3f ms, miss %8.3f ms, iterate %8.3f ms (%d)\n", label,
+		inserttime / div, hittime / div, misstime / div, itertime / div, found);
+}
+
+template<class KT>
+static void BenchMaps(const char *label, const TArray<KT> &keys, const TArray<KT> &misses, int repeat)
+{
+	Printf(TEXTCOLOR_YELLOW "%s, %u keys\n", label, keys.Size());
+	BenchMap<TMap<KT, unsigned>>("TMap", keys, misses, repeat);
+	BenchMap<TFlatMap<KT, unsigned>>("TFlatMap", keys, misses, repeat);
+}
+
+CCMD(mapbench)
+{
+	int repeat = argv.argc() > 1 ? (int)strtol(argv[1], nullptr, 10) : 10;
+	if (repeat < 1) repeat = 1;
+
+	TArray<FName> names, missnames;
+	TArray<FString> strings, missstrings;
+	for (int i = 1; FName(ENamedName(i)).IsValidName(); i++)
+	{
+		FName name = ENamedName(i);
+		// Every other name is left out to be looked up as a miss.
+		(i & 1 ? names : missnames).Push(name);
+		(i & 1 ? strings : missstrings).Push(name.GetChars());
+	}
+
+	TArray<void *> pointers, misspointers;
+	for (unsigned i = 0; i < names.Size() * 2; i++)
+	{
+		(i & 1 ? pointers : misspointers).Push(new char[32]);
+	}
+
+	BenchMaps("FName", names, missnames, repeat);
+	BenchMaps("FString", strings, missstrings, repeat);
+	BenchMaps("Pointer", pointers, misspointers, repeat);
+
+	for (auto p : pointers) delete[] (char *)p;
+	for (auto p : misspointers) delete[] (char *)p;
+}
@@ -40,6 +40,7 @@
 #include "resourcefile.h"
 #include "cmdlib.h"
 #include "printf.h"
+#include "m_argv.h"
 
 
 
@@ -51,6 +52,29 @@
 
 extern ISzAlloc g_Alloc;
 
+//-----------------------------------------------------------------------
+//
+// Solid archives store many files in one compressed block, so reading
+// one file means decoding everything before it in its block. Decoded
+// blocks are kept in a per-archive LRU list so that reading all files
+// of a block, in any order, costs one decode. The amount of memory
+// (in MB) can be set with -7zcache. The most recently used block is
+// always kept, no matter how large it is.
+//
+//-----------------------------------------------------------------------
+
+static size_t BlockCacheSize()
+{
+	static size_t cachesize = 0;
+	if (cachesize == 0)
+	{
+		const char *arg = Args->CheckValue("-7zcache");
+		int mb = arg != nullptr ? atoi(arg) : 0;
+		cachesize = size_t(mb > 0 ? mb : 64) << 20;
+	}
+	return cachesize;
+}
+
 struct CZDFileInStream
 {
 	ISeekInStream s;
@@ -109,9 +133,14 @@ struct C7zArchive
 	CZDFileInStream ArchiveStream;
 	CLookToRead2 LookStream;
 	Byte StreamBuffer[1<<14];
-	UInt32 BlockIndex;
-	Byte *OutBuffer;
-	size_t OutBufferSize;
+
+	struct FBlock
+	{
+		UInt32 Index;
+		Byte *Buffer;
+		size_t Size;
+	};
+	TArray<FBlock> Blocks;	// decoded solid blocks, most recently used first.
 
 	C7zArchive(FileReader &file) : ArchiveStream(file)
 	{
@@ -126,16 +155,13 @@ struct C7zArchive
 		LookStream.bufSize = sizeof(StreamBuffer);
 		LookStream.buf = StreamBuffer;
 		SzArEx_Init(&DB);
-		BlockIndex = 0xFFFFFFFF;
-		OutBuffer = NULL;
-		OutBufferSize = 0;
 	}
 
 	~C7zArchive()
 	{
-		if (OutBuffer != NULL)
+		for (auto &block : Blocks)
 		{
-			IAlloc_Free(&g_Alloc, OutBuffer);
+			IAlloc_Free(&g_Alloc, block.Buffer);
 		}
 		SzArEx_Free(&DB, &g_Alloc);
 	}
@@ -147,17 +173,63 @@ struct C7zArchive
 
 	SRes Extract(UInt32 file_index, char *buffer)
 	{
+		// If the file's block is cached, SzArEx_Extract will use it as is, otherwise it decodes into a new one.
+		FBlock block = { 0xFFFFFFFF, NULL, 0 };
+		UInt32 folder = DB.FileToFolder[file_index];
+		for (unsigned i = 0; i < Blocks.Size(); i++)
+		{
+			if (Blocks[i].Index == folder)
+			{
+				block = Blocks[i];
+				Blocks.Delete(i);
+				break;
+			}
+		}
+
 		size_t offset, out_size_processed;
 		SRes res = SzArEx_Extract(&DB, &LookStream.vt, file_index,
-			&BlockIndex, &OutBuffer, &OutBufferSize,
+			&block.Index, &block.Buffer, &block.Size,
 			&offset, &out_size_processed,
 			&g_Alloc, &g_Alloc);
 		if (res == SZ_OK)
 		{
-			memcpy(buffer, OutBuffer + offset, out_size_processed);
+			memcpy(buffer, block.Buffer + offset, out_size_processed);
+		}
+
+		if (block.Buffer != NULL)
+		{
+			if (res == SZ_OK)
+			{
+				Blocks.Insert(0, block);
+				TrimBlocks();
+			}
+			else
+			{
+				// The block may not have been decoded completely.
+				IAlloc_Free(&g_Alloc, block.Buffer);
+			}
 		}
 		return res;
 	}
+
+	void TrimBlocks()
+	{
+		size_t limit = BlockCacheSize();
+		size_t total = 0;
+		for (unsigned i = 0; i < Blocks.Size(); i++)
+		{
+			total += Blocks[i].Size;
+			if (i > 0 && total > limit)
+			{
+				for (unsigned j = i; j < Blocks.Size(); j++)
+				{
+					IAlloc_Free(&g_Alloc, Blocks[j].Buffer);
+				}
+				Blocks.Resize(i);
+				break;
+			}
+		}
+	}
 };
 //==========================================================================
 //
@@ -215,19 +215,26 @@ FileReader *FRFFLump::GetReader()
 
 int FRFFLump::FillCache()
 {
-	int res = FUncompressedLump::FillCache();
+	if (!(Flags & LUMPF_COMPRESSED))
+	{
+		return FUncompressedLump::FillCache();
+	}
 
-	if (Flags & LUMPF_COMPRESSED)
+	// Encrypted lumps are decrypted in place, so they always need their own buffer.
+	// Pointing into the container like FUncompressedLump does would write into a read-only file mapping.
+	Owner->Reader.Seek(Position, FileReader::SeekSet);
+	Cache = new char[LumpSize];
+	Owner->Reader.Read(Cache, LumpSize);
+	RefCount = 1;
+
+	int cryptlen = MIN<int> (LumpSize, 256);
+	uint8_t *data = (uint8_t *)Cache;
+	
+	for (int i = 0; i < cryptlen; ++i)
 	{
-		int cryptlen = MIN<int> (LumpSize, 256);
-		uint8_t *data = (uint8_t *)Cache;
-		
-		for (int i = 0; i < cryptlen; ++i)
-		{
-			data[i] ^= i >> 1;
-		}
+		data[i] ^= i >> 1;
 	}
-	return res;
+	return 1;
 }
 
 
@@ -34,6 +34,7 @@
 */
 
 #include <time.h>
+#include <stdexcept>
 #include "file_zip.h"
 #include "cmdlib.h"
 #include "templates.h"
@@ -180,7 +181,7 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 
 	if (centraldir == 0)
 	{
-		if (!quiet) Printf(TEXTCOLOR_RED "\n%s: ZIP file corrupt!\n", FileName.GetChars());
+		if (!quiet) Message(TEXTCOLOR_RED "\n%s: ZIP file corrupt!\n", FileName.GetChars());
 		return false;
 	}
 
@@ -192,7 +193,7 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 	if (info.NumEntries != info.NumEntriesOnAllDisks ||
 		info.FirstDisk != 0 || info.DiskNumber != 0)
 	{
-		if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Multipart Zip files are not supported.\n", FileName.GetChars());
+		if (!quiet) Message(TEXTCOLOR_RED "\n%s: Multipart Zip files are not supported.\n", FileName.GetChars());
 		return false;
 	}
 
@@ -228,7 +229,7 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 		if (dirptr > ((char*)directory) + dirsize)	// This directory entry goes beyond the end of the file.
 		{
 			free(directory);
-			if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Central directory corrupted.", FileName.GetChars());
+			if (!quiet) Message(TEXTCOLOR_RED "\n%s: Central directory corrupted.", FileName.GetChars());
 			return false;
 		}
 
@@ -281,7 +282,7 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 		if (dirptr > ((char*)directory) + dirsize)	// This directory entry goes beyond the end of the file.
 		{
 			free(directory);
-			if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Central directory corrupted.", FileName.GetChars());
+			if (!quiet) Message(TEXTCOLOR_RED "\n%s: Central directory corrupted.", FileName.GetChars());
 			return false;
 		}
 		
@@ -301,7 +302,7 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 			zip_fh->Method != METHOD_IMPLODE &&
 			zip_fh->Method != METHOD_SHRINK)
 		{
-			if (!quiet) Printf(TEXTCOLOR_YELLOW "\n%s: '%s' uses an unsupported compression algorithm (#%d).\n", FileName.GetChars(), name.GetChars(), zip_fh->Method);
+			if (!quiet) Message(TEXTCOLOR_YELLOW "\n%s: '%s' uses an unsupported compression algorithm (#%d).\n", FileName.GetChars(), name.GetChars(), zip_fh->Method);
 			skipped++;
 			continue;
 		}
@@ -309,7 +310,7 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 		zip_fh->Flags = LittleShort(zip_fh->Flags);
 		if (zip_fh->Flags & ZF_ENCRYPTED)
 		{
-			if (!quiet) Printf(TEXTCOLOR_YELLOW "\n%s: '%s' is encrypted. Encryption is not supported.\n", FileName.GetChars(), name.GetChars());
+			if (!quiet) Message(TEXTCOLOR_YELLOW "\n%s: '%s' is encrypted. Encryption is not supported.\n", FileName.GetChars(), name.GetChars());
 			skipped++;
 			continue;
 		}
@@ -434,6 +435,42 @@ int FZipLump::FillCache()
 	return 1;
 }
 
+//==========================================================================
+//
+// Only lumps inside archives held in memory can be decompressed in the
+// background because the file reader itself cannot be shared between
+// threads. The bzip2 decompressor uses global state so it is excluded.
+//
+//==========================================================================
+
+bool FZipLump::CanReadAsync()
+{
+	if (Method != METHOD_DEFLATE && Method != METHOD_LZMA) return false;
+	if (Owner->Reader.GetBuffer() == nullptr) return false;
+	if (NeedFileStart) SetLumpAddress();
+	return true;
+}
+
+bool FZipLump::ReadAsync(char *buffer)
+{
+	// Errors are not reported here. If this fails, the lump will be read normally which takes care of that.
+	try
+	{
+		FileReader mr;
+		mr.OpenMemory(Owner->Reader.GetBuffer() + Position, CompressedSize);
+		FileReader frz;
+		if (!frz.OpenDecompressor(mr, LumpSize, Method, false, [](const char* err) { throw std::runtime_error(err); }))
+		{
+			return false;
+		}
+		return frz.Read(buffer, LumpSize) == LumpSize;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
 //==========================================================================
 //
 //
@@ -20,6 +20,8 @@ struct FZipLump : public FResourceLump
 
 	virtual FileReader *GetReader();
 	virtual int FillCache();
+	virtual bool CanReadAsync() override;
+	virtual bool ReadAsync(char *buffer) override;
 
 private:
 	void SetLumpAddress();
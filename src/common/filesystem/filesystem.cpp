@@ -46,6 +46,12 @@
 #include "m_crc32.h"
 #include "printf.h"
 #include "md5.h"
+#include "i_time.h"
+#include "file_zip.h"
+#include "w_zip.h"
+#include <thread>
+#include <atomic>
+#include <vector>
 
 extern	FILE* hashfile;
 
@@ -140,6 +146,8 @@ struct FileSystem::LumpRecord
 // PRIVATE FUNCTION PROTOTYPES ---------------------------------------------
 
 static void PrintLastError ();
+static bool UseMappedFiles();
+static void OpenArchivesInParallel(const TArray<FString> &filenames, TArray<FResourceFile *> &prepared, bool quiet, LumpFilterInfo *filter);
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
@@ -196,20 +204,26 @@ void FileSystem::InitSingleFile(const char* filename, bool quiet)
 void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, LumpFilterInfo* filter)
 {
 	int numfiles;
+	uint64_t starttime = I_nsTime();
 
 	// open all the files, load headers, and count lumps
 	DeleteAll();
 	numfiles = 0;
 
+	TArray<FResourceFile *> prepared;
+	OpenArchivesInParallel(filenames, prepared, quiet, filter);
+	uint64_t opentime = I_nsTime();
+
 	for(unsigned i=0;i<filenames.Size(); i++)
 	{
 		int baselump = NumEntries;
-		AddFile (filenames[i], nullptr, quiet, filter);
+		AddFile (filenames[i], nullptr, quiet, filter, prepared[i]);
 		
 		if (i == (unsigned)MaxIwadIndex) MoveLumpsInFolder("after_iwad/");
 		FStringf path("filter/%s", Files.Last()->GetHash().GetChars());
 		MoveLumpsInFolder(path);
 	}
+	uint64_t addtime = I_nsTime();
 	
 	NumEntries = FileInfo.Size();
 	if (NumEntries == 0)
@@ -218,9 +232,122 @@ void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, Lump
 		else return;
 	}
 	if (filter && filter->postprocessFunc) filter->postprocessFunc();
+	uint64_t postprocesstime = I_nsTime();
 
 	// [RH] Set up hash table
 	InitHashChains ();
+
+	const char *stat = Args->CheckValue("-stat");
+	if (!quiet && stat != nullptr && !stricmp(stat, "startup"))
+	{
+		uint64_t endtime = I_nsTime();
+		Printf("File system: %u files, %d lumps in %.1f ms\n", Files.Size(), NumEntries, (endtime - starttime) / 1e6);
+		Printf("  opening archives: %.1f ms\n", (opentime - starttime) / 1e6);
+		Printf("  adding files:     %.1f ms\n", (addtime - opentime) / 1e6);
+		Printf("  postprocessing:   %.1f ms\n", (postprocesstime - addtime) / 1e6);
+		Printf("  hash chains:      %.1f ms\n", (endtime - postprocesstime) / 1e6);
+	}
+}
+
+//==========================================================================
+//
+// OpenArchivesInParallel
+//
+// Most of the time spent adding a large number of files goes into reading
+// the zip directories, so all zip based archives get opened on worker
+// threads first. Everything that depends on the load order still happens
+// in AddFile, which takes over the opened files. Anything that fails here
+// is left to AddFile, so that it can report the error.
+//
+//==========================================================================
+
+static FResourceFile *OpenZipArchive(const char *filename, bool quiet, LumpFilterInfo *filter)
+{
+	bool isdir;
+	if (!DirEntryExists(filename, &isdir) || isdir)
+	{
+		return nullptr;
+	}
+
+	FileReader reader;
+	if (!(UseMappedFiles() && reader.OpenFileMapped(filename)) && !reader.OpenFile(filename))
+	{
+		return nullptr;
+	}
+
+	char head[4];
+	if (reader.GetLength() < (long)sizeof(FZipLocalFileHeader) || reader.Read(head, 4) != 4 || memcmp(head, "PK\x3\x4", 4))
+	{
+		return nullptr;
+	}
+	reader.Seek(0, FileReader::SeekSet);
+
+	auto rf = new FZipFile(filename, reader);
+	rf->DeferMessages = true;
+	if (!rf->Open(quiet, filter))
+	{
+		delete rf;
+		return nullptr;
+	}
+	rf->DeferMessages = false;
+	return rf;
+}
+
+static void OpenArchivesInParallel(const TArray<FString> &filenames, TArray<FResourceFile *> &prepared, bool quiet, LumpFilterInfo *filter)
+{
+	prepared.Resize(filenames.Size());
+	for (auto &p : prepared) p = nullptr;
+
+	unsigned numthreads = std::min<unsigned>(std::thread::hardware_concurrency(), filenames.Size());
+	if (numthreads < 2 || Args->CheckParm("-noparallelopen"))
+	{
+		return;
+	}
+	UseMappedFiles();	// Check the command line before any worker does.
+
+	// FString's reference counting is not thread safe, so every worker
+	// gets its own copy of the filter strings instead of sharing them.
+	// Empty strings are fine since the shared null string is never counted.
+	std::vector<LumpFilterInfo> filters(numthreads);
+	auto copyfilter = [](TArray<FString> &to, const TArray<FString> &from)
+	{
+		for (auto &s : from) to.Push(s.GetChars());
+	};
+	if (filter != nullptr)
+	{
+		for (auto &f : filters)
+		{
+			copyfilter(f.gameTypeFilter, filter->gameTypeFilter);
+			copyfilter(f.reservedFolders, filter->reservedFolders);
+			copyfilter(f.requiredPrefixes, filter->requiredPrefixes);
+			f.dotFilter = filter->dotFilter.GetChars();
+		}
+	}
+
+	std::atomic<unsigned> next = { 0 };
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < numthreads; t++)
+	{
+		LumpFilterInfo *tfilter = filter != nullptr ? &filters[t] : nullptr;
+		threads.emplace_back([&, tfilter]()
+		{
+			for (unsigned i; (i = next++) < filenames.Size(); )
+			{
+				try
+				{
+					prepared[i] = OpenZipArchive(filenames[i].GetChars(), quiet, tfilter);
+				}
+				catch (...)
+				{
+					// AddFile will try again and deal with it.
+				}
+			}
+		});
+	}
+	for (auto &t : threads)
+	{
+		t.join();
+	}
 }
 
 //==========================================================================
@@ -270,6 +397,23 @@ int FileSystem::AddFromBuffer(const char* name, const char* type, char* data, in
 	return FileInfo.Size()-1;
 }
  
+//==========================================================================
+//
+// UseMappedFiles
+//
+// Resource files get mapped into memory so that uncompressed lumps can be
+// used in place instead of being copied to the heap. This needs a 64 bit
+// address space for large mod collections. -nomapfiles reverts to reading
+// the files through stdio.
+//
+//==========================================================================
+
+static bool UseMappedFiles()
+{
+	static bool usemap = sizeof(void *) >= 8 && !Args->CheckParm("-nomapfiles");
+	return usemap;
+}
+
 //==========================================================================
 //
 // AddFile
@@ -277,16 +421,23 @@ int FileSystem::AddFromBuffer(const char* name, const char* type, char* data, in
 // Files with a .wad extension are wadlink files with multiple lumps,
 // other files are single lumps with the base filename for the lump name.
 //
+// 'prepared' is an archive that already got opened by
+// OpenArchivesInParallel.
+//
 // [RH] Removed reload hack
 //==========================================================================
 
-void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, LumpFilterInfo* filter)
+void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, LumpFilterInfo* filter, FResourceFile *prepared)
 {
 	int startlump;
 	bool isdir = false;
 	FileReader filereader;
 
-	if (filer == nullptr)
+	if (prepared != nullptr)
+	{
+		// Nothing to open.
+	}
+	else if (filer == nullptr)
 	{
 		// Does this exist? If so, is it a directory?
 		if (!DirEntryExists(filename, &isdir))
@@ -301,7 +452,7 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 
 		if (!isdir)
 		{
-			if (!filereader.OpenFile(filename))
+			if (!(UseMappedFiles() && filereader.OpenFileMapped(filename)) && !filereader.OpenFile(filename))
 			{ // Didn't find file
 				if (!quiet)
 				{
@@ -319,7 +470,16 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 
 	FResourceFile *resfile;
 	
-	if (!isdir)
+	if (prepared != nullptr)
+	{
+		resfile = prepared;
+		if (resfile->DeferredMessages.IsNotEmpty())
+		{
+			Printf("%s", resfile->DeferredMessages.GetChars());
+			resfile->DeferredMessages = "";
+		}
+	}
+	else if (!isdir)
 		resfile = FResourceFile::OpenResourceFile(filename, filereader, quiet, false, filter);
 	else
 		resfile = FResourceFile::OpenDirectory(filename, quiet, filter);
@@ -835,8 +995,6 @@ uint32_t FileSystem::LumpNameHash (const char *s)
 
 void FileSystem::InitHashChains (void)
 {
-	unsigned int i, j;
-
 	Hashes.Resize(8 * NumEntries);
 	// Mark all buckets as empty
 	memset(Hashes.Data(), -1, Hashes.Size() * sizeof(Hashes[0]));
@@ -850,34 +1008,78 @@ void FileSystem::InitHashChains (void)
 	NextLumpIndex_ResId = &Hashes[NumEntries * 7];
 
 
-	// Now set up the chains
-	for (i = 0; i < (unsigned)NumEntries; i++)
+	// Now set up the chains. Each of them only writes its own two arrays,
+	// so for large directories they get built on separate threads.
+	auto shortnames = [this]()
 	{
-		j = LumpNameHash (FileInfo[i].shortName.String) % NumEntries;
-		NextLumpIndex[i] = FirstLumpIndex[j];
-		FirstLumpIndex[j] = i;
-
-		// Do the same for the full paths
-		if (FileInfo[i].longName.IsNotEmpty())
+		for (unsigned i = 0; i < (unsigned)NumEntries; i++)
 		{
-			j = MakeKey(FileInfo[i].longName) % NumEntries;
-			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
-			FirstLumpIndex_FullName[j] = i;
-
-			FString nameNoExt = FileInfo[i].longName;
-			auto dot = nameNoExt.LastIndexOf('.');
-			auto slash = nameNoExt.LastIndexOf('/');
-			if (dot > slash) nameNoExt.Truncate(dot);
+			unsigned j = LumpNameHash (FileInfo[i].shortName.String) % NumEntries;
+			NextLumpIndex[i] = FirstLumpIndex[j];
+			FirstLumpIndex[j] = i;
+		}
+	};
 
-			j = MakeKey(nameNoExt) % NumEntries;
-			NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
-			FirstLumpIndex_NoExt[j] = i;
+	// Do the same for the full paths
+	auto fullnames = [this]()
+	{
+		for (unsigned i = 0; i < (unsigned)NumEntries; i++)
+		{
+			if (FileInfo[i].longName.IsNotEmpty())
+			{
+				unsigned j = MakeKey(FileInfo[i].longName.GetChars()) % NumEntries;
+				NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
+				FirstLumpIndex_FullName[j] = i;
+			}
+		}
+	};
 
-			j = FileInfo[i].resourceId % NumEntries;
-			NextLumpIndex_ResId[i] = FirstLumpIndex_ResId[j];
-			FirstLumpIndex_ResId[j] = i;
+	auto noext = [this]()
+	{
+		for (unsigned i = 0; i < (unsigned)NumEntries; i++)
+		{
+			if (FileInfo[i].longName.IsNotEmpty())
+			{
+				// Hash the name without its extension in place. Copying the FString would not be thread safe.
+				const FString &name = FileInfo[i].longName;
+				auto dot = name.LastIndexOf('.');
+				auto slash = name.LastIndexOf('/');
+				size_t len = dot > slash ? dot : name.Len();
+
+				unsigned j = MakeKey(name.GetChars(), len) % NumEntries;
+				NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
+				FirstLumpIndex_NoExt[j] = i;
+			}
+		}
+	};
 
+	auto resids = [this]()
+	{
+		for (unsigned i = 0; i < (unsigned)NumEntries; i++)
+		{
+			if (FileInfo[i].longName.IsNotEmpty())
+			{
+				unsigned j = FileInfo[i].resourceId % NumEntries;
+				NextLumpIndex_ResId[i] = FirstLumpIndex_ResId[j];
+				FirstLumpIndex_ResId[j] = i;
+			}
 		}
+	};
+
+	if (NumEntries >= 20000 && std::thread::hardware_concurrency() >= 4)
+	{
+		std::thread t1(fullnames), t2(noext), t3(resids);
+		shortnames();
+		t1.join();
+		t2.join();
+		t3.join();
+	}
+	else
+	{
+		shortnames();
+		fullnames();
+		noext();
+		resids();
 	}
 	FileInfo.ShrinkToFit();
 	Files.ShrinkToFit();
@@ -1401,6 +1603,61 @@ FileReader FileSystem::ReopenFileReader(int lump, bool alwayscache)
 	return rl->NewReader();	// This always gets a reader to the cache
 }
 
+//==========================================================================
+//
+// GetFileView
+//
+// Returns a pointer to the lump's data inside its container, which is only
+// possible if the container is held in memory and the lump is not
+// compressed. The data remains valid until the file system gets
+// reinitialized. Returns nullptr if the lump has to be read instead.
+//
+//==========================================================================
+
+const void *FileSystem::GetFileView(int lump)
+{
+	if ((unsigned)lump >= (unsigned)FileInfo.Size() || FileInfo[lump].lump->LumpSize == 0)
+	{
+		return nullptr;
+	}
+
+	auto rl = FileInfo[lump].lump;
+	if (rl->Flags & LUMPF_COMPRESSED)
+	{
+		return nullptr;
+	}
+	auto rd = rl->GetReader();
+	const char *buffer = rd != nullptr ? rd->GetBuffer() : nullptr;
+	int offset = rl->GetFileOffset();
+	if (buffer == nullptr || offset < 0)
+	{
+		return nullptr;
+	}
+	return buffer + offset;
+}
+
+//==========================================================================
+//
+// PrefetchFile
+//
+// Starts decompressing a lump on a worker thread. See FResourceLump::Prefetch.
+// DropPrefetches frees everything that was prefetched but not read yet.
+//
+//==========================================================================
+
+void FileSystem::PrefetchFile(int lump)
+{
+	if ((unsigned)lump < (unsigned)FileInfo.Size())
+	{
+		FileInfo[lump].lump->Prefetch();
+	}
+}
+
+void FileSystem::DropPrefetches()
+{
+	FResourceLump::DropPrefetches();
+}
+
 FileReader FileSystem::OpenFileReader(const char* name)
 {
 	auto lump = CheckNumForFullName(name);
@@ -69,7 +69,7 @@ public:
 
 	void InitSingleFile(const char *filename, bool quiet = false);
 	void InitMultipleFiles (TArray<FString> &filenames, bool quiet = false, LumpFilterInfo* filter = nullptr);
-	void AddFile (const char *filename, FileReader *wadinfo, bool quiet, LumpFilterInfo* filter);
+	void AddFile (const char *filename, FileReader *wadinfo, bool quiet, LumpFilterInfo* filter, FResourceFile *prepared = nullptr);
 	int CheckIfResourceFileLoaded (const char *name) noexcept;
 	void AddAdditionalFile(const char* filename, FileReader* wadinfo = NULL) {}
 
@@ -143,6 +143,9 @@ public:
 	FileReader OpenFileReader(int lump);		// opens a reader that redirects to the containing file's one.
 	FileReader ReopenFileReader(int lump, bool alwayscache = false);		// opens an independent reader.
 	FileReader OpenFileReader(const char* name);
+	const void *GetFileView(int lump);		// returns the lump's data without copying if it is stored uncompressed in a file held in memory, otherwise nullptr.
+	void PrefetchFile(int lump);			// starts decompressing a compressed lump on a worker thread so that reading it later does not stall.
+	void DropPrefetches();					// frees all prefetched data that has not been read yet.
 
 	int FindLump (const char *name, int *lastlump, bool anyns=false);		// [RH] Find lumps with duplication
 	int FindLumpMulti (const char **names, int *lastlump, bool anyns = false, int *nameindex = NULL); // same with multiple possible names
@@ -38,6 +38,11 @@
 #include "resourcefile.h"
 #include "cmdlib.h"
 #include "md5.h"
+#include "printf.h"
+#include "m_argv.h"
+#include "ctpl.h"
+#include <future>
+#include <thread>
 
 
 //==========================================================================
@@ -73,6 +78,7 @@ public:
 
 FResourceLump::~FResourceLump()
 {
+	DropPrefetch();
 	if (Cache != NULL && RefCount >= 0)
 	{
 		delete [] Cache;
@@ -200,13 +206,135 @@ void *FResourceLump::Lock()
 	{
 		if (RefCount > 0) RefCount++;
 	}
-	else if (LumpSize > 0)
+	else if (LumpSize > 0 && !ClaimPrefetch())
 	{
 		FillCache();
 	}
 	return Cache;
 }
 
+//==========================================================================
+//
+// Prefetching
+//
+// Lumps that support it can be read on a worker thread ahead of time,
+// so that the first Lock does not have to decompress them. Lock waits
+// for the result if it isn't ready yet. Everything here is only called
+// from the main thread, the workers only see the lump and its buffer.
+// The amount of unclaimed data is capped, and whoever requested the
+// prefetches should drop the leftovers once it is done reading.
+// -noprefetch disables this.
+//
+//==========================================================================
+
+struct FPrefetch
+{
+	char *Buffer;
+	std::future<bool> Result;
+};
+
+static const size_t MaxPrefetchBytes = 64 << 20;
+static size_t PrefetchBytes;
+
+// These are never destroyed so that lumps deleted during shutdown can still look themselves up.
+static TMap<FResourceLump *, FPrefetch *> &Prefetches()
+{
+	static auto map = new TMap<FResourceLump *, FPrefetch *>;
+	return *map;
+}
+
+static ctpl::thread_pool &PrefetchPool()
+{
+	static ctpl::thread_pool *pool;
+	if (pool == nullptr)
+	{
+		int numthreads = (int)std::thread::hardware_concurrency() - 1;
+		pool = new ctpl::thread_pool(numthreads < 1 ? 1 : numthreads > 4 ? 4 : numthreads);
+	}
+	return *pool;
+}
+
+void FResourceLump::Prefetch()
+{
+	static bool noprefetch = Args->CheckParm("-noprefetch");
+	if (noprefetch || LumpSize <= 0 || Cache != NULL || PrefetchBytes + LumpSize > MaxPrefetchBytes || Prefetches().CheckKey(this) != nullptr)
+	{
+		return;
+	}
+	if (!CanReadAsync())
+	{
+		return;
+	}
+
+	auto job = new FPrefetch;
+	job->Buffer = new char[LumpSize];
+	job->Result = PrefetchPool().push([=](int) { return ReadAsync(job->Buffer); });
+	Prefetches()[this] = job;
+	PrefetchBytes += LumpSize;
+}
+
+bool FResourceLump::ClaimPrefetch()
+{
+	if (PrefetchBytes == 0)
+	{
+		return false;
+	}
+	auto pjob = Prefetches().CheckKey(this);
+	if (pjob == nullptr)
+	{
+		return false;
+	}
+	auto job = *pjob;
+	Prefetches().Remove(this);
+	PrefetchBytes -= LumpSize;
+
+	bool success = job->Result.get();
+	if (success)
+	{
+		Cache = job->Buffer;
+		RefCount = 1;
+	}
+	else
+	{
+		// The normal read will report the error.
+		delete[] job->Buffer;
+	}
+	delete job;
+	return success;
+}
+
+void FResourceLump::DropPrefetch()
+{
+	if (PrefetchBytes == 0)
+	{
+		return;
+	}
+	auto pjob = Prefetches().CheckKey(this);
+	if (pjob != nullptr)
+	{
+		auto job = *pjob;
+		Prefetches().Remove(this);
+		PrefetchBytes -= LumpSize;
+		job->Result.wait();
+		delete[] job->Buffer;
+		delete job;
+	}
+}
+
+void FResourceLump::DropPrefetches()
+{
+	TMap<FResourceLump *, FPrefetch *>::Iterator it(Prefetches());
+	TMap<FResourceLump *, FPrefetch *>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		pair->Value->Result.wait();
+		delete[] pair->Value->Buffer;
+		delete pair->Value;
+	}
+	Prefetches().Clear();
+	PrefetchBytes = 0;
+}
+
 //==========================================================================
 //
 // Decrements reference counter and frees lump if counter reaches 0
@@ -295,6 +423,31 @@ FResourceFile::~FResourceFile()
 {
 }
 
+//==========================================================================
+//
+// FResourceFile :: Message
+//
+// Prints a message about this file, unless it is being opened on a worker
+// thread. In that case the message is kept until the file gets added to
+// the file system.
+//
+//==========================================================================
+
+void FResourceFile::Message(const char *fmt, ...)
+{
+	va_list argptr;
+	va_start(argptr, fmt);
+	if (DeferMessages)
+	{
+		DeferredMessages.VAppendFormat(fmt, argptr);
+	}
+	else
+	{
+		VPrintf(PRINT_HIGH, fmt, argptr);
+	}
+	va_end(argptr);
+}
+
 int lumpcmp(const void * a, const void * b)
 {
 	FResourceLump * rec1 = (FResourceLump *)a;
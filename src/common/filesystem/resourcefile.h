@@ -114,9 +114,17 @@ public:
 	void CheckEmbedded();
 	virtual FCompressedBuffer GetRawData();
 
+	// For FileSystem::PrefetchFile. CanReadAsync gets called on the main thread and may set up the lump.
+	// ReadAsync runs on a worker thread, so it may only use data that does not change while the file is open.
+	virtual bool CanReadAsync() { return false; }
+	virtual bool ReadAsync(char *buffer) { return false; }
+
 	void *Lock(); // validates the cache and increases the refcount.
 	int Unlock(); // decreases the refcount and frees the buffer
 
+	void Prefetch();	// reads the lump on a worker thread if it can be. The next Lock picks up the result.
+	static void DropPrefetches();
+
 	unsigned Size() const{ return LumpSize; }
 	int LockCount() const { return RefCount; }
 	const char* getName() { return FullName.GetChars(); }
@@ -124,6 +132,10 @@ public:
 protected:
 	virtual int FillCache() { return -1; }
 
+private:
+	bool ClaimPrefetch();
+	void DropPrefetch();
+
 };
 
 class FResourceFile
@@ -131,6 +143,12 @@ class FResourceFile
 public:
 	FileReader Reader;
 	FString FileName;
+
+	// Set while the file gets opened on a worker thread, so that messages
+	// are collected instead of printed. See FileSystem::InitMultipleFiles.
+	bool DeferMessages = false;
+	FString DeferredMessages;
+
 protected:
 	uint32_t NumLumps;
 	FString Hash;
@@ -141,6 +159,7 @@ protected:
 	// for archives that can contain directories
 	void GenerateHash();
 	void PostProcessArchive(void *lumps, size_t lumpsize, LumpFilterInfo *filter);
+	void Message(const char *fmt, ...);
 
 private:
 	uint32_t FirstLump;
@@ -8776,6 +8776,60 @@ FxExpression *FxVMFunctionCall::Resolve(FCompileContext& ctx)
 	return this;
 }
 
+//==========================================================================
+//
+// Devirtualization
+//
+// Once the function build list gets processed all classes and their
+// virtual tables are complete. Classes created later (e.g. by Dehacked)
+// only copy their parent's table, so a virtual function that is not
+// overridden anywhere below the receiver's static type can be called
+// directly. This allows the JIT to use direct native calls for them.
+//
+//==========================================================================
+
+static TMap<PClass *, TArray<bool>> OverriddenVirtuals;
+static bool DevirtualizeReady;
+static unsigned DevirtualizedCalls;
+
+void InitDevirtualization()
+{
+	OverriddenVirtuals.Clear();
+	DevirtualizedCalls = 0;
+	for (auto cls : PClass::AllClasses)
+	{
+		auto parent = cls->ParentClass;
+		if (parent == nullptr) continue;
+		for (unsigned i = 0; i < parent->Virtuals.Size() && i < cls->Virtuals.Size(); i++)
+		{
+			if (cls->Virtuals[i] == parent->Virtuals[i]) continue;
+			// This slot has more than one implementation below every ancestor that has it.
+			for (auto p = parent; p != nullptr && i < p->Virtuals.Size(); p = p->ParentClass)
+			{
+				auto &slots = OverriddenVirtuals[p];
+				while (slots.Size() < p->Virtuals.Size()) slots.Push(false);
+				slots[i] = true;
+			}
+		}
+	}
+	DevirtualizeReady = true;
+}
+
+unsigned ClearDevirtualization()
+{
+	OverriddenVirtuals.Clear();
+	DevirtualizeReady = false;
+	return DevirtualizedCalls;
+}
+
+static VMFunction *GetDevirtualizedTarget(PClass *cls, unsigned index)
+{
+	if (!DevirtualizeReady || cls == nullptr || index >= cls->Virtuals.Size()) return nullptr;
+	auto slots = OverriddenVirtuals.CheckKey(cls);
+	if (slots != nullptr && index < slots->Size() && (*slots)[index]) return nullptr;
+	return cls->Virtuals[index];
+}
+
 //==========================================================================
 //
 //
@@ -8799,10 +8853,24 @@ ExpEmit FxVMFunctionCall::Emit(VMFunctionBuilder *build)
 	}
 
 	VMFunction *vmfunc = Function->Variants[0].Implementation;
+	VMFunction *callfunc = vmfunc;
 	bool staticcall = ((vmfunc->VarFlags & VARF_Final) || vmfunc->VirtualIndex == ~0u || NoVirtual);
 
+	if (!staticcall && (Function->Variants[0].Flags & VARF_Method) && Self->ValueType->isObjectPointer())
+	{
+		// The VTBL instruction aborts on a null receiver. Native functions check self themselves,
+		// script functions only get called directly if the receiver is self, which cannot be null.
+		auto direct = GetDevirtualizedTarget(static_cast<PObjectPointer *>(Self->ValueType)->PointedClass(), vmfunc->VirtualIndex);
+		if (direct != nullptr && ((direct->VarFlags & VARF_Native) || Self->ExprType == EFX_Self))
+		{
+			callfunc = direct;
+			staticcall = true;
+			DevirtualizedCalls++;
+		}
+	}
+
 	count = 0;
-	FunctionCallEmitter emitters(vmfunc);
+	FunctionCallEmitter emitters(callfunc);
 	// Emit code to pass implied parameters
 	ExpEmit selfemit;
 	if (Function->Variants[0].Flags & VARF_Method)
@@ -10792,6 +10860,7 @@ ExpEmit FxLocalVariableDeclaration::Emit(VMFunctionBuilder *build)
 					{
 						if (!registers.IsDirty(reg))
 						{
+							registers.NeedsClear(reg, 1);
 							continue;
 						}
 
@@ -10829,6 +10898,7 @@ ExpEmit FxLocalVariableDeclaration::Emit(VMFunctionBuilder *build)
 				else
 				{
 					RegNum = build->Registers[REGT_POINTER].Get(1);
+					build->Registers[REGT_POINTER].NeedsClear(RegNum, 1);
 				}
 			}
 		}
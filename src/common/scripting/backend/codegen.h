@@ -2140,4 +2140,7 @@ struct CompileEnvironment
 
 extern CompileEnvironment compileEnvironment;
 
+void InitDevirtualization();
+unsigned ClearDevirtualization();
+
 #endif
@@ -37,8 +37,20 @@
 #include "m_argv.h"
 #include "c_cvars.h"
 #include "jit.h"
+#include "printf.h"
 
 CVAR(Bool, strictdecorate, false, CVAR_GLOBALCONFIG | CVAR_ARCHIVE)
+EXTERN_CVAR(Bool, vm_jit)
+EXTERN_CVAR(Bool, vm_jit_background)
+
+// Bytecode optimization level, set with -vmoptlevel:
+// 0: off, 1: jump threading and removal of no-op instructions, 2: also compacts the code by removing dead instructions.
+static int VMOptLevel = 1;
+
+static struct
+{
+	unsigned Before, After, Threaded;
+} VMOptStats;
 
 struct VMRemap
 {
@@ -111,6 +123,7 @@ void VMFunctionBuilder::EndStatement()
 
 void VMFunctionBuilder::MakeFunction(VMScriptFunction *func)
 {
+	Optimize(VMOptLevel);
 	func->Alloc(Code.Size(), IntConstantList.Size(), FloatConstantList.Size(), StringConstantList.Size(), AddressConstantList.Size(), LineNumbers.Size());
 
 	// Copy code block.
@@ -141,6 +154,12 @@ void VMFunctionBuilder::MakeFunction(VMScriptFunction *func)
 	func->NumRegA = Registers[REGT_POINTER].MostUsed;
 	func->NumRegS = Registers[REGT_STRING].MostUsed;
 	func->MaxParam = MaxParam;
+	if (VMOptLevel > 0)
+	{
+		func->ZeroRegD = Registers[REGT_INT].MostCleared;
+		func->ZeroRegF = Registers[REGT_FLOAT].MostCleared;
+		func->ZeroRegA = Registers[REGT_POINTER].MostCleared;
+	}
 	func->StackSize = VMFrame::FrameSize(func->NumRegD, func->NumRegF, func->NumRegS, func->NumRegA, func->MaxParam, func->ExtraSpace);
 
 	// Technically, there's no reason why we can't end the function with
@@ -149,6 +168,155 @@ void VMFunctionBuilder::MakeFunction(VMScriptFunction *func)
 	assert(ActiveParam == 0);
 }
 
+//==========================================================================
+//
+// VMFunctionBuilder :: Optimize
+//
+// Simple peephole optimizations on the finished code. Everything here
+// must keep the instruction pairs the interpreter and the JIT rely on
+// intact: the JMP following a comparison and the jump table following
+// an IJMP may neither be moved nor be jumped over.
+//
+//==========================================================================
+
+static bool SkipsNextInstruction(int op)
+{
+	return op == OP_TEST || op == OP_TESTN || op == OP_CMPS || (OpInfo[op].Mode & MODE_ATYPE) == MODE_ACMP;
+}
+
+void VMFunctionBuilder::Optimize(int level)
+{
+	unsigned count = Code.Size();
+	VMOptStats.Before += count;
+	if (level <= 0 || count == 0)
+	{
+		VMOptStats.After += count;
+		return;
+	}
+
+	TArray<bool> pinned(count, true);
+	memset(pinned.Data(), 0, count * sizeof(bool));
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (SkipsNextInstruction(Code[i].op))
+		{
+			if (i + 1 < count) pinned[i + 1] = true;
+		}
+		else if (Code[i].op == OP_IJMP)
+		{
+			for (unsigned j = 1; j <= (unsigned)Code[i].i16 && i + j < count; j++) pinned[i + j] = true;
+		}
+	}
+
+	// Thread jumps to unconditional jumps straight through to their final destination.
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (Code[i].op != OP_JMP) continue;
+		unsigned target = i + 1 + Code[i].i24;
+		unsigned newtarget = target;
+		// The limit guards against jump cycles.
+		for (int n = 0; n < 16 && newtarget < count && newtarget != i && Code[newtarget].op == OP_JMP && !pinned[newtarget]; n++)
+		{
+			newtarget = newtarget + 1 + Code[newtarget].i24;
+		}
+		if (newtarget != target)
+		{
+			Code[i].i24 = int(newtarget - i - 1);
+			VMOptStats.Threaded++;
+		}
+	}
+
+	// Jumps to the next instruction and moves of a register onto itself do nothing.
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (pinned[i]) continue;
+		auto &op = Code[i];
+		switch (op.op)
+		{
+		case OP_JMP:
+			if (op.i24 == 0) op.op = OP_NOP;
+			break;
+
+		case OP_MOVE:
+		case OP_MOVEF:
+		case OP_MOVES:
+		case OP_MOVEA:
+		case OP_MOVEV2:
+		case OP_MOVEV3:
+			if (op.a == op.b) op.op = OP_NOP;
+			break;
+		}
+	}
+
+	if (level >= 2)
+	{
+		// Find everything reachable from the entry point.
+		TArray<bool> live(count, true);
+		memset(live.Data(), 0, count * sizeof(bool));
+		TArray<unsigned> work;
+		work.Push(0);
+		unsigned i;
+		while (work.Pop(i))
+		{
+			if (i >= count || live[i]) continue;
+			live[i] = true;
+
+			auto &op = Code[i];
+			if (op.op == OP_JMP)
+			{
+				work.Push(i + 1 + op.i24);
+				continue;
+			}
+			if ((op.op == OP_RET && (op.b == REGT_NIL || (op.a & RET_FINAL))) || (op.op == OP_RETI && (op.a & RET_FINAL)))
+			{
+				continue;
+			}
+			if (op.op == OP_IJMP)
+			{
+				for (unsigned j = 2; j <= (unsigned)op.i16; j++) work.Push(i + j);
+			}
+			if (SkipsNextInstruction(op.op)) work.Push(i + 2);
+			work.Push(i + 1);
+		}
+
+		// Every instruction maps to the next one that is kept.
+		TArray<unsigned> newindex(count + 1, true);
+		unsigned newcount = 0;
+		for (i = 0; i < count; i++)
+		{
+			newindex[i] = newcount;
+			if (live[i] && (Code[i].op != OP_NOP || pinned[i])) newcount++;
+		}
+		newindex[count] = newcount;
+
+		if (newcount < count)
+		{
+			for (i = 0; i < count; i++)
+			{
+				if (newindex[i] == newindex[i + 1]) continue;	// removed
+				VMOP op = Code[i];
+				if (op.op == OP_JMP)
+				{
+					op.i24 = int(newindex[i + 1 + op.i24] - newindex[i] - 1);
+				}
+				Code[newindex[i]] = op;
+			}
+			Code.Resize(newcount);
+
+			// Statements that lost all their code merge into the following one.
+			unsigned numlines = 0;
+			for (auto &line : LineNumbers)
+			{
+				line.InstructionIndex = (uint16_t)newindex[line.InstructionIndex];
+				if (numlines > 0 && LineNumbers[numlines - 1].InstructionIndex == line.InstructionIndex) numlines--;
+				LineNumbers[numlines++] = line;
+			}
+			LineNumbers.Resize(numlines);
+		}
+	}
+	VMOptStats.After += Code.Size();
+}
+
 //==========================================================================
 //
 // VMFunctionBuilder :: FillIntConstants
@@ -371,6 +539,7 @@ VMFunctionBuilder::RegAvailability::RegAvailability()
 	memset(Used, 0, sizeof(Used));
 	memset(Dirty, 0, sizeof(Dirty));
 	MostUsed = 0;
+	MostCleared = 0;
 }
 
 //==========================================================================
@@ -813,6 +982,11 @@ void FFunctionBuildList::Build()
 {
 	VMDisassemblyDumper disasmdump(VMDisassemblyDumper::Overwrite);
 
+	const char *optlevel = Args->CheckValue("-vmoptlevel");
+	if (optlevel != nullptr) VMOptLevel = (int)strtol(optlevel, nullptr, 0);
+	VMOptStats = {};
+	if (VMOptLevel > 0) InitDevirtualization();
+
 	for (auto &item : mItems)
 	{
 		assert(item.Code != NULL);
@@ -913,8 +1087,23 @@ void FFunctionBuildList::Build()
 	}
 	VMFunction::CreateRegUseInfo();
 	FScriptPosition::StrictErrors = strictdecorate;
+	unsigned devirtualized = ClearDevirtualization();
+	if (VMOptLevel > 0)
+	{
+		DPrintf(DMSG_NOTIFY, "Bytecode optimizer level %d: %u instructions before, %u after, %u jumps threaded, %u virtual calls made direct\n",
+			VMOptLevel, VMOptStats.Before, VMOptStats.After, VMOptStats.Threaded, devirtualized);
+	}
 
 	if (FScriptPosition::ErrorCounter == 0 && Args->CheckParm("-dumpjit")) DumpJit();
+	if (FScriptPosition::ErrorCounter == 0 && vm_jit && vm_jit_background)
+	{
+		TArray<VMScriptFunction *> funcs;
+		for (auto &item : mItems)
+		{
+			if (item.Function != nullptr) funcs.Push(item.Function);
+		}
+		JitQueueFunctions(funcs);
+	}
 	mItems.Clear();
 	mItems.ShrinkToFit();
 	FxAlloc.FreeAllBlocks();
@@ -1051,8 +1240,6 @@ void FunctionCallEmitter::AddParameterStringConst(const FString &konst)
 	});
 }
 
-EXTERN_CVAR(Bool, vm_jit)
-
 ExpEmit FunctionCallEmitter::EmitCall(VMFunctionBuilder *build, TArray<ExpEmit> *ReturnRegs)
 {
 	unsigned paramcount = 0;
@@ -37,6 +37,12 @@ public:
 		void Return(int reg, int count);
 		bool Reuse(int regnum);
 
+		// The code relies on these registers being zero when the function is entered.
+		void NeedsClear(int reg, int count)
+		{
+			if (reg + count > MostCleared) MostCleared = reg + count;
+		}
+
 		bool IsDirty(int reg) const
 		{
 			const int firstword = reg / 32;
@@ -48,6 +54,7 @@ public:
 		VM_UWORD Used[256/32];		// Bitmap of used registers (bit set means reg is used)
 		VM_UWORD Dirty[256/32];
 		int MostUsed;
+		int MostCleared;
 
 		friend class VMFunctionBuilder;
 	};
@@ -106,6 +113,8 @@ public:
 	TArray<FxLocalVariableDeclaration *> ConstructedStructs;
 
 private:
+	void Optimize(int level);
+
 	TArray<FStatementInfo> LineNumbers;
 	TArray<FxExpression *> StatementStack;
 
@@ -9,7 +9,10 @@ extern PStruct *TypeVector3;
 
 static void OutputJitLog(const asmjit::StringLogger &logger);
 
-JitFuncPtr JitCompile(VMScriptFunction *sfunc)
+// Serializes all code generation and the runtime tables, as functions can now also be compiled by the background thread.
+std::mutex JitMutex;
+
+JitFuncPtr JitCompile(VMScriptFunction *sfunc, bool quiet)
 {
 #if 0
 	if (strcmp(sfunc->PrintableName.GetChars(), "StatusScreen.drawNum") != 0)
@@ -17,6 +20,7 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 #endif
 
 	using namespace asmjit;
+	std::lock_guard<std::mutex> lock(JitMutex);
 	StringLogger logger;
 	try
 	{
@@ -31,6 +35,8 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 	}
 	catch (const CRecoverableError &e)
 	{
+		// The background compiler must not print. The main thread will retry the function and report the error then.
+		if (quiet) return nullptr;
 		OutputJitLog(logger);
 		Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName.GetChars(), e.what());
 		return nullptr;
@@ -40,6 +46,7 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 void JitDumpLog(FILE *file, VMScriptFunction *sfunc)
 {
 	using namespace asmjit;
+	std::lock_guard<std::mutex> lock(JitMutex);
 	StringLogger logger;
 	try
 	{
@@ -3,6 +3,8 @@
 
 #include "vmintern.h"
 
-JitFuncPtr JitCompile(VMScriptFunction *func);
+JitFuncPtr JitCompile(VMScriptFunction *func, bool quiet = false);
+void JitQueueFunctions(const TArray<VMScriptFunction *> &funcs);
+void JitStopBackground();
 void JitDumpLog(FILE *file, VMScriptFunction *func);
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames);
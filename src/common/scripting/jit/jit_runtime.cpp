@@ -305,7 +305,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 	if (result == 0)
 		I_Error("RtlAddFunctionTable failed");
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	// Deep copies: FString's reference count is not atomic and this may run on the background compiler thread.
+	JitDebugInfo.Push({ FString(compiler->GetScriptFunction()->PrintableName.GetChars()), FString(compiler->GetScriptFunction()->SourceFileName.GetChars()), compiler->LineInfo, startaddr, endaddr });
 #endif
 
 	return p;
@@ -729,7 +730,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 #endif
 	}
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	// Deep copies: FString's reference count is not atomic and this may run on the background compiler thread.
+	JitDebugInfo.Push({ FString(compiler->GetScriptFunction()->PrintableName.GetChars()), FString(compiler->GetScriptFunction()->SourceFileName.GetChars()), compiler->LineInfo, startaddr, endaddr });
 
 	return p;
 }
@@ -737,6 +739,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 void JitRelease()
 {
+	JitStopBackground();
+	std::lock_guard<std::mutex> lock(JitMutex);
 #ifdef _WIN64
 	for (auto p : JitFrames)
 	{
@@ -954,6 +958,7 @@ FString JitGetStackFrameName(NativeSymbolResolver *nativeSymbols, void *pc)
 
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames)
 {
+	std::lock_guard<std::mutex> lock(JitMutex);
 	void *frames[32];
 	int numframes = CaptureStackTrace(32, frames);
 
@@ -12,6 +12,7 @@
 #include <asmjit/x86.h>
 #include <functional>
 #include <vector>
+#include <mutex>
 
 extern cycle_t VMCycles[10];
 extern int VMCalls[10];
@@ -333,5 +334,7 @@ public:
 	}
 };
 
+extern std::mutex JitMutex;
+
 void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler);
 asmjit::CodeInfo GetHostCodeInfo();
@@ -55,6 +55,7 @@ extern FMemArena ClassDataAllocator;
 #define MAX_TRY_DEPTH	8	// Maximum number of nested TRYs in a single function
 
 void JitRelease();
+void VMProfileReset();
 
 extern void (*VM_CastSpriteIDToString)(FString* a, unsigned int b);
 
@@ -430,13 +431,14 @@ public:
 	void operator delete[](void *block) {}
 	static void DeleteAll()
 	{
+		// also release any JIT data. This must come first, so that the background compiler is stopped before its functions go away.
+		JitRelease();
+		VMProfileReset();
 		for (auto f : AllFunctions)
 		{
 			f->~VMFunction();
 		}
 		AllFunctions.Clear();
-		// also release any JIT data
-		JitRelease();
 	}
 	static void CreateRegUseInfo()
 	{
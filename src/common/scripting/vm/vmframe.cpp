@@ -43,6 +43,10 @@
 #include "jit.h"
 #include "c_cvars.h"
 #include "version.h"
+#include "files.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #ifdef HAVE_VM_JIT
 #ifdef __DragonFly__
@@ -54,14 +58,20 @@ CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
 	Printf("You must restart " GAMENAME " for this change to take effect.\n");
 	Printf("This cvar is currently not saved. You must specify it on the command line.");
 }
+// Compile all script functions on a worker thread after loading instead of stalling on each function's first call.
+CVAR(Bool, vm_jit_background, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 #else
 CVAR(Bool, vm_jit, false, CVAR_NOINITCALL|CVAR_NOSET)
+CVAR(Bool, vm_jit_background, false, CVAR_NOINITCALL|CVAR_NOSET)
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames) { return FString(); }
 void JitRelease() {}
+void JitQueueFunctions(const TArray<VMScriptFunction *> &funcs) {}
+void JitStopBackground() {}
 #endif
 
 cycle_t VMCycles[10];
 int VMCalls[10];
+int VMFrameBytes[10];
 
 #if 0
 IMPLEMENT_CLASS(VMException, false, false)
@@ -134,6 +144,8 @@ VMScriptFunction::VMScriptFunction(FName name)
 	NumKonstA = 0;
 	MaxParam = 0;
 	NumArgs = 0;
+	// Functions that were not made by VMFunctionBuilder get all their registers cleared.
+	ZeroRegD = ZeroRegF = ZeroRegA = 0xffff;
 	ScriptCall = &VMScriptFunction::FirstScriptCall;
 }
 
@@ -268,7 +280,7 @@ int VMScriptFunction::PCToLine(const VMOP *pc)
 	return -1;
 }
 
-static bool CanJit(VMScriptFunction *func)
+static bool CanJit(VMScriptFunction *func, bool quiet = false)
 {
 	// Asmjit has a 256 register limit. Stay safely away from it as the jit compiler uses a few for temporaries as well.
 	// Any function exceeding the limit will use the VM - a fair punishment to someone for writing a function so bloated ;)
@@ -277,17 +289,124 @@ static bool CanJit(VMScriptFunction *func)
 	if (func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS < maxregs)
 		return true;
 
-	Printf(TEXTCOLOR_ORANGE "%s is using too many registers (%d of max %d)! Function will not use native code.\n", func->PrintableName.GetChars(), func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS, maxregs);
+	if (!quiet) Printf(TEXTCOLOR_ORANGE "%s is using too many registers (%d of max %d)! Function will not use native code.\n", func->PrintableName.GetChars(), func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS, maxregs);
 
 	return false;
 }
 
+#ifdef HAVE_VM_JIT
+
+//==========================================================================
+//
+// Background JIT compiler
+//
+// A single worker thread compiles the queued functions in the order they
+// were built. A function that gets called before the worker reached it is
+// moved to the urgent list so it gets compiled next; until then it runs in
+// the interpreter. Only the main thread ever changes ScriptCall.
+//
+//==========================================================================
+
+static std::thread JitThread;
+static std::mutex JitQueueMutex;
+static std::condition_variable JitQueueCondition;
+static TArray<VMScriptFunction *> JitPending;
+static TArray<VMScriptFunction *> JitUrgent;
+static unsigned JitPendingPos;
+static bool JitStopRequested;
+
+static void JitWorkerMain()
+{
+	while (true)
+	{
+		VMScriptFunction *func;
+		{
+			std::unique_lock<std::mutex> lock(JitQueueMutex);
+			JitQueueCondition.wait(lock, [] { return JitStopRequested || JitUrgent.Size() > 0 || JitPendingPos < JitPending.Size(); });
+			if (JitStopRequested) return;
+			if (JitUrgent.Size() > 0) JitUrgent.Pop(func);
+			else func = JitPending[JitPendingPos++];
+		}
+
+		int state = func->JitState.load();
+		if (state != VMScriptFunction::JITSTATE_Queued && state != VMScriptFunction::JITSTATE_Urgent) continue;
+
+		func->JitResult = JitCompile(func, true);
+		func->JitState.store(func->JitResult ? VMScriptFunction::JITSTATE_Compiled : VMScriptFunction::JITSTATE_Failed);
+	}
+}
+
+void JitQueueFunctions(const TArray<VMScriptFunction *> &funcs)
+{
+	std::unique_lock<std::mutex> lock(JitQueueMutex);
+	for (auto func : funcs)
+	{
+		// Functions the JIT cannot handle are left alone so that FirstScriptCall reports them as before.
+		if (func->JitState.load() != VMScriptFunction::JITSTATE_None || !CanJit(func, true)) continue;
+		func->JitState.store(VMScriptFunction::JITSTATE_Queued);
+		JitPending.Push(func);
+	}
+	if (!JitThread.joinable() && JitPendingPos < JitPending.Size())
+	{
+		static bool registered;
+		if (!registered)
+		{
+			// A joinable std::thread must not be destroyed, which would happen on any exit path that skips VMFunction::DeleteAll.
+			atexit(JitStopBackground);
+			registered = true;
+		}
+		JitStopRequested = false;
+		JitThread = std::thread(JitWorkerMain);
+	}
+	lock.unlock();
+	JitQueueCondition.notify_one();
+}
+
+void JitStopBackground()
+{
+	if (!JitThread.joinable()) return;
+	{
+		std::unique_lock<std::mutex> lock(JitQueueMutex);
+		JitStopRequested = true;
+	}
+	JitQueueCondition.notify_one();
+	JitThread.join();
+	JitPending.Reset();
+	JitUrgent.Reset();
+	JitPendingPos = 0;
+}
+
+#endif // HAVE_VM_JIT
+
 int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
 {
 #ifdef HAVE_VM_JIT
-	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	int state = sfunc->JitState.load();
+	if (state == JITSTATE_Queued)
 	{
-		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
+		// Needed now, so move it to the front of the line and interpret it in the meantime.
+		if (sfunc->JitState.compare_exchange_strong(state, JITSTATE_Urgent))
+		{
+			{
+				std::unique_lock<std::mutex> lock(JitQueueMutex);
+				JitUrgent.Push(sfunc);
+			}
+			JitQueueCondition.notify_one();
+			return VMExec(func, params, numparams, ret, numret);
+		}
+	}
+	if (state == JITSTATE_Urgent)
+	{
+		return VMExec(func, params, numparams, ret, numret);
+	}
+	else if (state == JITSTATE_Compiled)
+	{
+		func->ScriptCall = sfunc->JitResult;
+	}
+	else if (vm_jit && CanJit(sfunc))
+	{
+		func->ScriptCall = JitCompile(sfunc);
 		if (!func->ScriptCall)
 			func->ScriptCall = VMExec;
 	}
@@ -398,10 +517,21 @@ VMFrame *VMFrameStack::AllocFrame(VMScriptFunction *func)
 	frame->NumRegA = func->NumRegA;
 	frame->MaxParam = func->MaxParam;
 	frame->Func = func;
+
+	// Only the registers that may be read before being written need to be
+	// cleared. The parameter area is always filled by PARAM before a call.
+	int d, f, a;
+	if ((d = MIN<int>(func->ZeroRegD, func->NumRegD)) > 0) memset(frame->GetRegD(), 0, d * sizeof(int));
+	if ((f = MIN<int>(func->ZeroRegF, func->NumRegF)) > 0) memset(frame->GetRegF(), 0, f * sizeof(double));
+	if ((a = MIN<int>(func->ZeroRegA, func->NumRegA)) > 0) memset(frame->GetRegA(), 0, a * sizeof(void *));
 	frame->InitRegS();
-	if (func->SpecialInits.Size())
+	if (func->ExtraSpace != 0)
 	{
-		func->InitExtra(frame->GetExtra());
+		memset(frame->GetExtra(), 0, func->ExtraSpace);
+		if (func->SpecialInits.Size())
+		{
+			func->InitExtra(frame->GetExtra());
+		}
 	}
 	return frame;
 }
@@ -411,7 +541,8 @@ VMFrame *VMFrameStack::AllocFrame(VMScriptFunction *func)
 // VMFrameStack :: Alloc
 //
 // Allocates space for a frame. Its size will be rounded up to a multiple
-// of 16 bytes.
+// of 16 bytes. Only the frame header is cleared, AllocFrame takes care of
+// the registers.
 //
 //===========================================================================
 
@@ -460,7 +591,8 @@ VMFrame *VMFrameStack::Alloc(int size)
 		Blocks = block;
 	}
 	frame = (VMFrame *)block->FreeSpace;
-	memset(frame, 0, size);
+	memset(frame, 0, sizeof(VMFrame));
+	VMFrameBytes[0] += size;
 	frame->ParentFrame = parent;
 	block->FreeSpace += size;
 	block->LastFrame = frame;
@@ -738,11 +870,247 @@ ADD_STAT(VM)
 		peak = MAX<double>(peak, d.TimeMS());
 	}
 	for (auto d : VMCalls) addedc += d;
+	int64_t framebytes = 0;
+	for (auto d : VMFrameBytes) framebytes += d;
 	memmove(&VMCycles[1], &VMCycles[0], 9 * sizeof(cycle_t));
 	memmove(&VMCalls[1], &VMCalls[0], 9 * sizeof(int));
+	memmove(&VMFrameBytes[1], &VMFrameBytes[0], 9 * sizeof(int));
 	VMCycles[0].Reset();
 	VMCalls[0] = 0;
-	return FStringf("VM time in last 10 tics: %f ms, %d calls, peak = %f ms", added, addedc, peak);
+	VMFrameBytes[0] = 0;
+	return FStringf("VM time in last 10 tics: %f ms, %d calls, peak = %f ms, %lld frame bytes/tic", added, addedc, peak, (long long)(framebytes / 10));
+}
+
+//==========================================================================
+//
+// Script function profiler
+//
+// While active, every script function's ScriptCall is replaced by
+// ProfileScriptCall, which times the call and forwards it to the real
+// entry point. Interpreted and JIT compiled code both call script
+// functions through ScriptCall, so this covers either. Time is recorded
+// per call path, the per-function totals are derived from that.
+//
+//==========================================================================
+
+struct VMProfileNode
+{
+	VMScriptFunction *Func;
+	unsigned Parent;
+	unsigned FirstChild;	// 0 terminates the lists because the root can never be a child.
+	unsigned NextSibling;
+	unsigned Calls;
+	cycle_t Time;
+};
+
+static TArray<VMProfileNode> ProfileNodes;
+static unsigned ProfileCurrent;
+static bool ProfileActive;
+
+static unsigned GetProfileNode(VMScriptFunction *func)
+{
+	for (unsigned n = ProfileNodes[ProfileCurrent].FirstChild; n != 0; n = ProfileNodes[n].NextSibling)
+	{
+		if (ProfileNodes[n].Func == func) return n;
+	}
+	VMProfileNode node = { func, ProfileCurrent, 0, ProfileNodes[ProfileCurrent].FirstChild, 0 };
+	node.Time.Reset();
+	unsigned index = ProfileNodes.Push(node);
+	ProfileNodes[ProfileCurrent].FirstChild = index;
+	return index;
+}
+
+static int ProfileScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto sfunc = static_cast<VMScriptFunction *>(func);
+
+	// Restores the profiler's state even if the call gets aborted.
+	struct ProfileScope
+	{
+		VMScriptFunction *func;
+		unsigned parent, node;
+
+		~ProfileScope()
+		{
+			if (node < ProfileNodes.Size()) ProfileNodes[node].Time.Unclock();
+			ProfileCurrent = parent < ProfileNodes.Size() ? parent : 0;
+			// FirstScriptCall replaces ScriptCall once the function has been compiled.
+			if (ProfileActive && func->ScriptCall != ProfileScriptCall)
+			{
+				func->ProfiledCall = func->ScriptCall;
+				func->ScriptCall = ProfileScriptCall;
+			}
+		}
+	} scope = { sfunc, ProfileCurrent, GetProfileNode(sfunc) };
+
+	ProfileNodes[scope.node].Calls++;
+	ProfileCurrent = scope.node;
+	ProfileNodes[scope.node].Time.Clock();
+	return sfunc->ProfiledCall(func, params, numparams, ret, numret);
+}
+
+static void VMProfileStop()
+{
+	if (!ProfileActive) return;
+	for (auto f : VMFunction::AllFunctions)
+	{
+		if (!(f->VarFlags & VARF_Native) && f->ScriptCall == ProfileScriptCall)
+		{
+			f->ScriptCall = static_cast<VMScriptFunction *>(f)->ProfiledCall;
+		}
+	}
+	ProfileActive = false;
+}
+
+static void VMProfileStart()
+{
+	VMProfileStop();
+	ProfileNodes.Clear();
+	ProfileNodes.Push({ nullptr, 0, 0, 0, 0 });
+	ProfileNodes[0].Time.Reset();
+	ProfileCurrent = 0;
+	for (auto f : VMFunction::AllFunctions)
+	{
+		if (!(f->VarFlags & VARF_Native))
+		{
+			auto sfunc = static_cast<VMScriptFunction *>(f);
+			sfunc->ProfiledCall = sfunc->ScriptCall;
+			sfunc->ScriptCall = ProfileScriptCall;
+		}
+	}
+	ProfileActive = true;
+}
+
+void VMProfileReset()
+{
+	VMProfileStop();
+	ProfileNodes.Reset();
+	ProfileCurrent = 0;
+}
+
+static double GetProfileSelfTime(unsigned node)
+{
+	double time = ProfileNodes[node].Time.TimeMS();
+	for (unsigned n = ProfileNodes[node].FirstChild; n != 0; n = ProfileNodes[n].NextSibling)
+	{
+		time -= ProfileNodes[n].Time.TimeMS();
+	}
+	return time;
+}
+
+static void VMProfileDump(int limit, const char *filename)
+{
+	struct FuncProfile
+	{
+		VMScriptFunction *func;
+		unsigned calls;
+		double inclusive, exclusive;
+	};
+
+	TArray<FuncProfile> funcs;
+	TMap<VMScriptFunction *, unsigned> funcindex;
+	for (unsigned node = 1; node < ProfileNodes.Size(); node++)
+	{
+		auto &n = ProfileNodes[node];
+		unsigned *index = funcindex.CheckKey(n.Func);
+		if (index == nullptr)
+		{
+			index = &funcindex.Insert(n.Func, funcs.Push({ n.Func, 0, 0, 0 }));
+		}
+		auto &fp = funcs[*index];
+		fp.calls += n.Calls;
+		fp.exclusive += GetProfileSelfTime(node);
+
+		// For recursive calls, only the outermost one counts towards the inclusive time.
+		bool recursive = false;
+		for (unsigned p = n.Parent; p != 0 && !recursive; p = ProfileNodes[p].Parent)
+		{
+			recursive = ProfileNodes[p].Func == n.Func;
+		}
+		if (!recursive) fp.inclusive += n.Time.TimeMS();
+	}
+
+	std::sort(funcs.begin(), funcs.end(), [](const FuncProfile &left, const FuncProfile &right)
+	{
+		return right.exclusive < left.exclusive;
+	});
+
+	Printf(TEXTCOLOR_YELLOW "Excl, ms    Incl, ms    Calls     Function\n");
+	Printf(TEXTCOLOR_YELLOW "----------  ----------  --------  --------------------\n");
+	const unsigned count = MIN<unsigned>(limit > 0 ? limit : UINT_MAX, funcs.Size());
+	for (unsigned i = 0; i < count; i++)
+	{
+		auto &fp = funcs[i];
+		Printf("%10.3f  %10.3f  %8u  %s\n", fp.exclusive, fp.inclusive, fp.calls, fp.func->PrintableName.GetChars());
+	}
+
+	if (filename != nullptr)
+	{
+		// One line per call path with its self time in microseconds, as expected by flamegraph.pl and similar tools.
+		FileWriter *fw = FileWriter::Open(filename);
+		if (fw == nullptr)
+		{
+			Printf(TEXTCOLOR_RED "Unable to write script profile to %s\n", filename);
+			return;
+		}
+		TArray<unsigned> path;
+		for (unsigned node = 1; node < ProfileNodes.Size(); node++)
+		{
+			long long us = (long long)(GetProfileSelfTime(node) * 1000.);
+			if (us <= 0) continue;
+
+			path.Clear();
+			for (unsigned p = node; p != 0; p = ProfileNodes[p].Parent) path.Push(p);
+			FString line;
+			for (unsigned i = path.Size(); i-- > 0; )
+			{
+				if (i + 1 < path.Size()) line += ';';
+				line += ProfileNodes[path[i]].Func->PrintableName;
+			}
+			fw->Printf("%s %lld\n", line.GetChars(), us);
+		}
+		delete fw;
+		Printf("Wrote folded script stacks to %s\n", filename);
+	}
+}
+
+CCMD(vmprofile)
+{
+	if (argv.argc() >= 2)
+	{
+		if (stricmp(argv[1], "start") == 0)
+		{
+			VMProfileStart();
+			Printf("Script profiling started\n");
+			return;
+		}
+		else if (stricmp(argv[1], "stop") == 0)
+		{
+			VMProfileStop();
+			Printf("Script profiling stopped\n");
+			return;
+		}
+		else if (stricmp(argv[1], "dump") == 0)
+		{
+			if (ProfileNodes.Size() == 0)
+			{
+				Printf("No script profile has been recorded\n");
+				return;
+			}
+			int limit = 30;
+			const char *filename = nullptr;
+			for (int i = 2; i < argv.argc(); i++)
+			{
+				char *end;
+				long num = strtol(argv[i], &end, 10);
+				if (*end == 0) limit = (int)num;
+				else filename = argv[i];
+			}
+			VMProfileDump(limit, filename);
+			return;
+		}
+	}
+	Printf("Usage: vmprofile start | stop | dump [count] [folded stacks file]\n");
 }
 
 //-----------------------------------------------------------------------------
@@ -2,6 +2,7 @@
 
 #include "vm.h"
 #include <csetjmp>
+#include <atomic>
 
 class VMScriptFunction;
 
@@ -471,8 +472,26 @@ public:
 	VM_UHALF NumKonstA;
 	VM_UHALF MaxParam;		// Maximum number of parameters this function has on the stack at once
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
+	VM_UHALF ZeroRegD;		// Number of leading registers that must be cleared when allocating a frame.
+	VM_UHALF ZeroRegF;		// Anything above these is always written before it is read.
+	VM_UHALF ZeroRegA;
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
 
+	// Background JIT compilation, see JitQueueFunctions. JitResult is only valid once JitState is JITSTATE_Compiled.
+	enum
+	{
+		JITSTATE_None,
+		JITSTATE_Queued,
+		JITSTATE_Urgent,
+		JITSTATE_Compiled,
+		JITSTATE_Failed,
+	};
+	std::atomic<int> JitState { JITSTATE_None };
+	JitFuncPtr JitResult = nullptr;
+
+	// The actual entry point while vmprofile has replaced ScriptCall.
+	JitFuncPtr ProfiledCall = nullptr;
+
 	void InitExtra(void *addr);
 	void DestroyExtra(void *addr);
 	int AllocExtraStack(PType *type);
@@ -173,8 +173,14 @@ TArray<uint8_t> FPatchTexture::CreatePalettedPixels(int conversion)
 	const column_t *maxcol;
 	int x;
 
-	FileData lump = fileSystem.ReadFile (SourceLump);
-	const patch_t *patch = (const patch_t *)lump.GetMem();
+	// Patches are read a lot, so avoid copying them if the file system can provide the data directly.
+	FileData lump;
+	const patch_t *patch = (const patch_t *)fileSystem.GetFileView(SourceLump);
+	if (patch == nullptr)
+	{
+		lump = fileSystem.ReadFile(SourceLump);
+		patch = (const patch_t *)lump.GetMem();
+	}
 
 	maxcol = (const column_t *)((const uint8_t *)patch + fileSystem.FileLength (SourceLump) - 3);
 
@@ -283,8 +289,13 @@ void FPatchTexture::DetectBadPatches ()
 	// Check if this patch is likely to be a problem.
 	// It must be 256 pixels tall, and all its columns must have exactly
 	// one post, where each post has a supposed length of 0.
-	FileData lump = fileSystem.ReadFile (SourceLump);
-	const patch_t *realpatch = (patch_t *)lump.GetMem();
+	FileData lump;
+	const patch_t *realpatch = (const patch_t *)fileSystem.GetFileView(SourceLump);
+	if (realpatch == nullptr)
+	{
+		lump = fileSystem.ReadFile(SourceLump);
+		realpatch = (const patch_t *)lump.GetMem();
+	}
 	const uint32_t *cofs = realpatch->columnofs;
 	int x, x2 = LittleShort(realpatch->width);
 
@@ -292,12 +303,12 @@ void FPatchTexture::DetectBadPatches ()
 	{
 		for (x = 0; x < x2; ++x)
 		{
-			const column_t *col = (column_t*)((uint8_t*)realpatch+LittleLong(cofs[x]));
+			const column_t *col = (const column_t*)((const uint8_t*)realpatch+LittleLong(cofs[x]));
 			if (col->topdelta != 0 || col->length != 0)
 			{
 				return;	// It's not bad!
 			}
-			col = (column_t *)((uint8_t *)col + 256 + 4);
+			col = (const column_t *)((const uint8_t *)col + 256 + 4);
 			if (col->topdelta != 0xFF)
 			{
 				return;	// More than one post in a column!
@@ -291,6 +291,8 @@ void FImageSource::CollectForPrecache(PrecacheInfo &info, bool requiretruecolor)
 	{
 		auto pair = std::make_pair(tc, !tc);
 		info.Insert(ImageID, pair);
+		// Get the decompression of the source data going while the other images are collected.
+		if (SourceLump >= 0) fileSystem.PrefetchFile(SourceLump);
 	}
 }
 
@@ -303,6 +305,8 @@ void FImageSource::EndPrecaching()
 {
 	precacheDataPaletted.Clear();
 	precacheDataRgba.Clear();
+	// Images that were already resident never read their prefetched data.
+	fileSystem.DropPrefetches();
 }
 
 void FImageSource::RegisterForPrecache(FImageSource *img, bool requiretruecolor)
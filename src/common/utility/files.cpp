@@ -33,6 +33,17 @@
 **
 */
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <limits.h>
+
 #include "files.h"
 #include "templates.h"	// just for 'clamp'
 #include "zstring.h"
@@ -348,6 +359,74 @@ public:
 };
 
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// Maps an entire file into memory, read only. Since GetBuffer returns the
+// mapped data, resource files opened with this can give out pointers to
+// their stored lumps instead of copying them.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+public:
+	~MappedFileReader()
+	{
+		if (bufptr != nullptr)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(bufptr);
+#else
+			munmap((void*)bufptr, Length);
+#endif
+		}
+	}
+
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		auto widename = WideString(filename);
+		HANDLE file = CreateFileW(widename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		HANDLE mapping = nullptr;
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && size.QuadPart <= LONG_MAX)
+		{
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		}
+		CloseHandle(file);
+		if (mapping == nullptr) return false;
+
+		// The view keeps the mapping alive.
+		bufptr = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (bufptr == nullptr) return false;
+		Length = (long)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat st;
+		void *mem = MAP_FAILED;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && st.st_size <= LONG_MAX)
+		{
+			mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		close(fd);
+		if (mem == MAP_FAILED) return false;
+
+		bufptr = (const char *)mem;
+		Length = (long)st.st_size;
+#endif
+		FilePos = 0;
+		return true;
+	}
+};
+
+
 
 //==========================================================================
 //
@@ -370,6 +449,19 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenFileMapped(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return false;
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
@@ -0,0 +1,492 @@
+#pragma once
+/*
+** tflatmap.h
+** Hash table with open addressing
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 The GZDoom Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** TFlatMap has the same interface as TMap, including the iterators, and
+** uses the same hash and value traits, so switching a table between the two
+** only requires changing its type.
+**
+** The difference is in the layout: TFlatMap keeps one control byte per slot
+** in a separate array, which holds 7 bits of the key's hash. Lookups probe
+** linearly through the control bytes and only look at a key when its control
+** byte matches, so a miss rarely touches the keys at all. Removing an entry
+** shifts the following entries of its probe sequence back, so there are no
+** tombstones and lookups never get slower over time.
+**
+** Unlike TMap, an empty TFlatMap does not allocate any memory.
+**
+*/
+
+#include "tarray.h"
+
+template<class KT, class VT, class MapType> class TFlatMapIterator;
+template<class KT, class VT, class MapType> class TFlatMapConstIterator;
+
+template<class KT, class VT, class HashTraits=THashTraits<KT>, class ValueTraits=TValueTraits<VT> >
+class TFlatMap
+{
+	template<class KTa, class VTa, class MTa> friend class TFlatMapIterator;
+	template<class KTb, class VTb, class MTb> friend class TFlatMapConstIterator;
+
+public:
+	typedef class TFlatMap<KT, VT, HashTraits, ValueTraits> MyType;
+	typedef class TFlatMapIterator<KT, VT, MyType> Iterator;
+	typedef class TFlatMapConstIterator<KT, VT, MyType> ConstIterator;
+	typedef struct { const KT Key; VT Value; } Pair;
+	typedef const Pair ConstPair;
+
+	TFlatMap() { SetSlotVector(0); }
+	TFlatMap(hash_t size) { SetSlotVector(size); }
+	~TFlatMap() { ClearSlotVector(); }
+
+	TFlatMap(const TFlatMap &o)
+	{
+		SetSlotVector(o.NumUsed);
+		CopySlots(o);
+	}
+
+	TFlatMap &operator= (const TFlatMap &o)
+	{
+		if (&o != this)
+		{
+			ClearSlotVector();
+			SetSlotVector(o.NumUsed);
+			CopySlots(o);
+		}
+		return *this;
+	}
+
+	//=======================================================================
+	//
+	// TransferFrom
+	//
+	// Moves the contents from one TFlatMap to another, leaving the map
+	// moved from empty.
+	//
+	//=======================================================================
+
+	void TransferFrom(TFlatMap &o)
+	{
+		ClearSlotVector();
+		Swap(o);
+	}
+
+	//=======================================================================
+	//
+	// Clear
+	//
+	// Empties out the table and resizes it with room for count entries.
+	//
+	//=======================================================================
+
+	void Clear(hash_t count=0)
+	{
+		ClearSlotVector();
+		SetSlotVector(count);
+	}
+
+	hash_t CountUsed() const
+	{
+		return NumUsed;
+	}
+
+	//=======================================================================
+	//
+	// operator[]
+	//
+	// Returns a reference to the value associated with a particular key,
+	// creating the pair if the key isn't already in the table.
+	//
+	//=======================================================================
+
+	VT &operator[] (const KT key)
+	{
+		IPair *p = FindKey(key);
+		if (p == nullptr)
+		{
+			p = NewKey(key);
+			ValueTraits traits;
+			traits.Init(p->Value);
+		}
+		return p->Value;
+	}
+
+	//=======================================================================
+	//
+	// CheckKey
+	//
+	// Returns a pointer to the value associated with a particular key, or
+	// NULL if the key isn't in the table.
+	//
+	//=======================================================================
+
+	VT *CheckKey (const KT key)
+	{
+		IPair *p = FindKey(key);
+		return p != nullptr ? &p->Value : nullptr;
+	}
+
+	const VT *CheckKey (const KT key) const
+	{
+		const IPair *p = FindKey(key);
+		return p != nullptr ? &p->Value : nullptr;
+	}
+
+	//=======================================================================
+	//
+	// Insert
+	//
+	// Adds a key/value pair to the table if key isn't in the table, or
+	// replaces the value for the existing pair if the key is in the table.
+	//
+	//=======================================================================
+
+	VT &Insert(const KT key, const VT &value)
+	{
+		IPair *p = FindKey(key);
+		if (p != nullptr)
+		{
+			p->Value = value;
+		}
+		else
+		{
+			p = NewKey(key);
+			::new(&p->Value) VT(value);
+		}
+		return p->Value;
+	}
+
+	VT &Insert(const KT key, VT &&value)
+	{
+		IPair *p = FindKey(key);
+		if (p != nullptr)
+		{
+			p->Value = std::move(value);
+		}
+		else
+		{
+			p = NewKey(key);
+			::new(&p->Value) VT(std::move(value));
+		}
+		return p->Value;
+	}
+
+	VT &InsertNew(const KT key)
+	{
+		IPair *p = FindKey(key);
+		if (p != nullptr)
+		{
+			p->Value.~VT();
+		}
+		else
+		{
+			p = NewKey(key);
+		}
+		::new(&p->Value) VT;
+		return p->Value;
+	}
+
+	//=======================================================================
+	//
+	// Remove
+	//
+	// Removes the key/value pair for a particular key if it is in the table.
+	//
+	//=======================================================================
+
+	void Remove(const KT key)
+	{
+		int slot = FindSlot(key);
+		if (slot >= 0)
+		{
+			DelSlot(slot);
+		}
+	}
+
+	void Swap(MyType &other)
+	{
+		std::swap(Slots, other.Slots);
+		std::swap(Ctrl, other.Ctrl);
+		std::swap(Size, other.Size);
+		std::swap(NumUsed, other.NumUsed);
+		std::swap(Shift, other.Shift);
+	}
+
+protected:
+	struct IPair	// This must be the same as Pair above, but with a
+	{				// non-const Key.
+		KT Key;
+		VT Value;
+	};
+
+	enum
+	{
+		MIN_SIZE = 8,
+		CTRL_USED = 0x80,	// Set for every used slot, the other 7 bits come from the hash.
+	};
+
+	IPair *Slots;
+	uint8_t *Ctrl;		// Behind the slots in the same allocation.
+	hash_t Size;		// 0 or a power of 2
+	hash_t NumUsed;
+	int Shift;			// Turns a mixed hash into a slot index.
+
+	// The hash traits frequently return the key itself, so the hash
+	// needs to be mixed first to spread keys like aligned pointers.
+	static hash_t Mix(hash_t hash)
+	{
+		return hash * 0x9E3779B1u;
+	}
+
+	static uint8_t Tag(hash_t mixed)
+	{
+		return uint8_t(CTRL_USED | ((mixed >> 8) & 0x7f));
+	}
+
+	void SetSlotVector(hash_t count)
+	{
+		NumUsed = 0;
+		if (count == 0)
+		{
+			Slots = nullptr;
+			Ctrl = nullptr;
+			Size = 0;
+			Shift = 32;
+			return;
+		}
+		// Keep the load factor at or below 7/8 so that every probe ends at an empty slot.
+		count += count / 7 + 1;
+		for (Size = MIN_SIZE, Shift = 29; Size < count; Size <<= 1, Shift--)
+		{ }
+		Slots = (IPair *)M_Malloc(Size * (sizeof(IPair) + 1));
+		Ctrl = (uint8_t *)(Slots + Size);
+		memset(Ctrl, 0, Size);
+	}
+
+	void ClearSlotVector()
+	{
+		for (hash_t i = 0; i < Size; ++i)
+		{
+			if (Ctrl[i] != 0)
+			{
+				Slots[i].~IPair();
+			}
+		}
+		M_Free(Slots);
+		Slots = nullptr;
+		Ctrl = nullptr;
+		Size = 0;
+		NumUsed = 0;
+		Shift = 32;
+	}
+
+	void Resize(hash_t count)
+	{
+		IPair *oldslots = Slots;
+		uint8_t *oldctrl = Ctrl;
+		hash_t oldsize = Size;
+
+		SetSlotVector(count);
+		for (hash_t i = 0; i < oldsize; ++i)
+		{
+			if (oldctrl[i] != 0)
+			{
+				IPair *p = NewKey(oldslots[i].Key);
+				::new(&p->Value) VT(std::move(oldslots[i].Value));
+				oldslots[i].~IPair();
+			}
+		}
+		M_Free(oldslots);
+	}
+
+	int FindSlot(const KT key) const
+	{
+		if (Size == 0)
+		{
+			return -1;
+		}
+		HashTraits Traits;
+		hash_t mixed = Mix(Traits.Hash(key));
+		uint8_t tag = Tag(mixed);
+		for (hash_t i = mixed >> Shift; ; i = (i + 1) & (Size - 1))
+		{
+			if (Ctrl[i] == tag && !Traits.Compare(Slots[i].Key, key))
+			{
+				return int(i);
+			}
+			if (Ctrl[i] == 0)
+			{
+				return -1;
+			}
+		}
+	}
+
+	IPair *FindKey(const KT key)
+	{
+		int slot = FindSlot(key);
+		return slot >= 0 ? &Slots[slot] : nullptr;
+	}
+
+	const IPair *FindKey(const KT key) const
+	{
+		int slot = FindSlot(key);
+		return slot >= 0 ? &Slots[slot] : nullptr;
+	}
+
+	// Adds a key that is not in the table yet. The Value field is left unconstructed.
+	IPair *NewKey(const KT key)
+	{
+		if ((NumUsed + 1) * 8 > Size * 7)
+		{
+			Resize(NumUsed * 2 + 1);
+		}
+		HashTraits Traits;
+		hash_t mixed = Mix(Traits.Hash(key));
+		hash_t i = mixed >> Shift;
+		while (Ctrl[i] != 0)
+		{
+			i = (i + 1) & (Size - 1);
+		}
+		Ctrl[i] = Tag(mixed);
+		++NumUsed;
+		::new(&Slots[i].Key) KT(key);
+		return &Slots[i];
+	}
+
+	void DelSlot(hash_t slot)
+	{
+		HashTraits Traits;
+		const hash_t mask = Size - 1;
+
+		Slots[slot].~IPair();
+		Ctrl[slot] = 0;
+		--NumUsed;
+
+		// Move every following entry of the probe sequence that would no
+		// longer be found back into the hole.
+		for (hash_t i = (slot + 1) & mask; Ctrl[i] != 0; i = (i + 1) & mask)
+		{
+			hash_t home = Mix(Traits.Hash(Slots[i].Key)) >> Shift;
+			if (((i - home) & mask) >= ((i - slot) & mask))
+			{
+				::new(&Slots[slot]) IPair(std::move(Slots[i]));
+				Slots[i].~IPair();
+				Ctrl[slot] = Ctrl[i];
+				Ctrl[i] = 0;
+				slot = i;
+			}
+		}
+	}
+
+	void CopySlots(const TFlatMap &o)
+	{
+		for (hash_t i = 0; i < o.Size; ++i)
+		{
+			if (o.Ctrl[i] != 0)
+			{
+				IPair *p = NewKey(o.Slots[i].Key);
+				::new(&p->Value) VT(o.Slots[i].Value);
+			}
+		}
+	}
+};
+
+// TFlatMapIterator ---------------------------------------------------------
+// A class to iterate over all the pairs in a TFlatMap. Like with TMap,
+// removing entries while iterating may cause others to be skipped.
+
+template<class KT, class VT, class MapType=TFlatMap<KT,VT> >
+class TFlatMapIterator
+{
+public:
+	TFlatMapIterator(MapType &map)
+		: Map(map), Position(0)
+	{
+	}
+
+	bool NextPair(typename MapType::Pair *&pair)
+	{
+		for (; Position < Map.Size; ++Position)
+		{
+			if (Map.Ctrl[Position] != 0)
+			{
+				pair = reinterpret_cast<typename MapType::Pair *>(&Map.Slots[Position++]);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Reset()
+	{
+		Position = 0;
+	}
+
+protected:
+	MapType &Map;
+	hash_t Position;
+};
+
+// TFlatMapConstIterator ----------------------------------------------------
+// Exactly the same as TFlatMapIterator, but it works with a const TFlatMap.
+
+template<class KT, class VT, class MapType=TFlatMap<KT,VT> >
+class TFlatMapConstIterator
+{
+public:
+	TFlatMapConstIterator(const MapType &map)
+		: Map(map), Position(0)
+	{
+	}
+
+	bool NextPair(typename MapType::ConstPair *&pair)
+	{
+		for (; Position < Map.Size; ++Position)
+		{
+			if (Map.Ctrl[Position] != 0)
+			{
+				pair = reinterpret_cast<typename MapType::ConstPair *>(&Map.Slots[Position++]);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Reset()
+	{
+		Position = 0;
+	}
+
+protected:
+	const MapType &Map;
+	hash_t Position;
+};
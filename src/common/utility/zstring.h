@@ -78,28 +78,8 @@ struct FStringData
 		return (const char *)(this + 1);
 	}
 
-	char *AddRef()
-	{
-		if (RefCount < 0)
-		{
-			return (char *)(MakeCopy() + 1);
-		}
-		else
-		{
-			RefCount++;
-			return (char *)(this + 1);
-		}
-	}
-
-	void Release()
-	{
-		assert (RefCount != 0);
-
-		if (--RefCount <= 0)
-		{
-			Dealloc();
-		}
-	}
+	char *AddRef();
+	void Release();
 
 	FStringData *MakeCopy();
 
@@ -356,7 +336,6 @@ protected:
 
 	void ResetToNull()
 	{
-		NullString.RefCount++;
 		Chars = &NullString.Nothing[0];
 	}
 
@@ -416,6 +395,32 @@ public:
 private:
 };
 
+// The null string is shared by all empty strings, so its reference count is never touched.
+// This keeps empty strings safe to create and destroy on worker threads.
+inline char *FStringData::AddRef()
+{
+	if (RefCount < 0)
+	{
+		return (char *)(MakeCopy() + 1);
+	}
+	else
+	{
+		if (this != (FStringData *)&FString::NullString) RefCount++;
+		return (char *)(this + 1);
+	}
+}
+
+inline void FStringData::Release()
+{
+	if (this == (FStringData *)&FString::NullString) return;
+	assert (RefCount != 0);
+
+	if (--RefCount <= 0)
+	{
+		Dealloc();
+	}
+}
+
 // These are also needed to block the default char * conversion operator from making a mess.
 bool operator == (const char *, const FString &) = delete;
 bool operator != (const char *, const FString &) = delete;
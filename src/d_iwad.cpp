@@ -48,6 +48,8 @@
 #include "v_text.h"
 #include "findfile.h"
 #include "i_interface.h"
+#include "i_specialpaths.h"
+#include <zlib.h>
 
 CVAR (Bool, queryiwad, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
 CVAR (String, defaultiwad, "", CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
@@ -354,7 +356,7 @@ int FIWadManager::ScanIWAD (const char *iwad)
 //
 //==========================================================================
 
-int FIWadManager::CheckIWADInfo(const char* fn)
+int FIWadManager::CheckIWADInfo(const char* fn, FString *infotext)
 {
 	FileSystem check;
 
@@ -370,35 +372,205 @@ int FIWadManager::CheckIWADInfo(const char* fn)
 		int num = check.CheckNumForName("IWADINFO");
 		if (num >= 0)
 		{
-			try
+			auto data = check.GetFileData(num);
+			int index = AddIWADInfo(fn, (const char*)data.Data(), data.Size());
+			if (index >= 0 && infotext != nullptr)
 			{
+				*infotext = FString((const char*)data.Data(), data.Size());
+			}
+			return index;
+		}
+		Printf(TEXTCOLOR_RED "%s: Unable to find IWADINFO\nFile has been removed from the list of IWADs\n", fn);
+		return -1;
+	}
+	Printf(TEXTCOLOR_RED "%s: Unable to open as resource file.\nFile has been removed from the list of IWADs\n", fn);
+	return -1;
+}
 
-				FIWADInfo result;
-				auto data = check.GetFileData(num);
-				ParseIWadInfo(fn, (const char*)data.Data(), data.Size(), &result);
+//==========================================================================
+//
+// Parses an IWAD's own definition lump and adds it to the list
+//
+//==========================================================================
 
-				for (unsigned i = 0, count = mIWadInfos.Size(); i < count; ++i)
-				{
-					if (mIWadInfos[i].Name == result.Name)
-					{
-						return i;
-					}
-				}
+int FIWadManager::AddIWADInfo(const char* fn, const char* data, int datasize)
+{
+	try
+	{
+		FIWADInfo result;
+		ParseIWadInfo(fn, data, datasize, &result);
 
-				mOrderNames.Push(result.Name);
-				return mIWadInfos.Push(result);
-			}
-			catch (CRecoverableError & err)
+		for (unsigned i = 0, count = mIWadInfos.Size(); i < count; ++i)
+		{
+			if (mIWadInfos[i].Name == result.Name)
 			{
-				Printf(TEXTCOLOR_RED "%s: %s\nFile has been removed from the list of IWADs\n", fn, err.what());
-				return -1;
+				return i;
 			}
 		}
-		Printf(TEXTCOLOR_RED "%s: Unable to find IWADINFO\nFile has been removed from the list of IWADs\n", fn);
+
+		mOrderNames.Push(result.Name);
+		return mIWadInfos.Push(result);
+	}
+	catch (CRecoverableError & err)
+	{
+		Printf(TEXTCOLOR_RED "%s: %s\nFile has been removed from the list of IWADs\n", fn, err.what());
 		return -1;
 	}
-	Printf(TEXTCOLOR_RED "%s: Unable to open as resource file.\nFile has been removed from the list of IWADs\n", fn);
-	return -1;
+}
+
+//==========================================================================
+//
+// IWadInfoSignature
+//
+// ScanIWAD's result depends on the current definitions' lump lists,
+// so cached scan results are only valid if these are unchanged.
+//
+//==========================================================================
+
+uint32_t FIWadManager::IWadInfoSignature() const
+{
+	uint32_t crc = crc32(0, nullptr, 0);
+	for (auto &info : mIWadInfos)
+	{
+		crc = crc32(crc, (const Bytef*)info.Name.GetChars(), info.Name.Len() + 1);
+		for (auto &lump : info.Lumps)
+		{
+			crc = crc32(crc, (const Bytef*)lump.GetChars(), lump.Len() + 1);
+		}
+	}
+	return crc;
+}
+
+//==========================================================================
+//
+// Identification cache
+//
+// Remembers what each IWAD candidate was identified as, keyed by its
+// path, size and modification time, so that unchanged files do not
+// have to be opened on every launch. -noiwadcache disables it.
+//
+//==========================================================================
+
+static const char IdentCacheMagic[] = "GZIW";
+static const uint32_t IdentCacheVersion = 1;
+
+static FString IdentCachePath(bool create)
+{
+	FString path = M_GetCachePath(create);
+	path << "/iwadident.cache";
+	return path;
+}
+
+static void WriteCacheLong(TArray<uint8_t> &f, uint32_t v)
+{
+	int p = f.Reserve(4);
+	f[p] = (uint8_t)v;
+	f[p + 1] = (uint8_t)(v >> 8);
+	f[p + 2] = (uint8_t)(v >> 16);
+	f[p + 3] = (uint8_t)(v >> 24);
+}
+
+static void WriteCacheString(TArray<uint8_t> &f, const FString &s)
+{
+	WriteCacheLong(f, s.Len());
+	int p = f.Reserve(s.Len());
+	memcpy(&f[p], s.GetChars(), s.Len());
+}
+
+struct FIdentCacheReader
+{
+	const uint8_t *pos, *end;
+
+	bool ReadLong(uint32_t &v)
+	{
+		if (end - pos < 4) return false;
+		v = pos[0] | (pos[1] << 8) | (pos[2] << 16) | ((uint32_t)pos[3] << 24);
+		pos += 4;
+		return true;
+	}
+
+	bool ReadString(FString &s)
+	{
+		uint32_t len;
+		if (!ReadLong(len) || (uint32_t)(end - pos) < len) return false;
+		s = FString((const char*)pos, len);
+		pos += len;
+		return true;
+	}
+};
+
+void FIWadManager::ReadIdentCache()
+{
+	mIdentCache.Clear();
+	mIdentCacheChanged = false;
+
+	FileReader fr;
+	if (!fr.OpenFile(IdentCachePath(false))) return;
+	auto data = fr.Read();
+	if (data.Size() < 12 || memcmp(data.Data(), IdentCacheMagic, 4)) return;
+
+	FIdentCacheReader rd = { data.Data() + 4, data.Data() + data.Size() };
+	uint32_t version, count;
+	if (!rd.ReadLong(version) || version != IdentCacheVersion || !rd.ReadLong(count)) return;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		FIWadCacheEntry entry;
+		uint32_t sizelo, sizehi, timelo, timehi, kind, index;
+		if (!rd.ReadString(entry.Path) || !rd.ReadLong(sizelo) || !rd.ReadLong(sizehi) || !rd.ReadLong(timelo) || !rd.ReadLong(timehi) ||
+			!rd.ReadLong(kind) || !rd.ReadLong(entry.Signature) || !rd.ReadLong(index) || !rd.ReadString(entry.IWadInfo))
+		{
+			// Truncated file. Whatever was read completely is still good.
+			break;
+		}
+		entry.Size = sizelo | ((uint64_t)sizehi << 32);
+		entry.ModTime = (int64_t)(timelo | ((uint64_t)timehi << 32));
+		entry.Kind = (uint8_t)kind;
+		entry.Index = (int)index;
+		mIdentCache.Push(entry);
+	}
+}
+
+void FIWadManager::WriteIdentCache()
+{
+	TArray<uint8_t> out;
+	unsigned count = 0;
+
+	out.Resize(4);
+	memcpy(out.Data(), IdentCacheMagic, 4);
+	WriteCacheLong(out, IdentCacheVersion);
+	int countpos = out.Reserve(4);
+
+	for (auto &entry : mIdentCache)
+	{
+		// Only keep what was actually looked at, so that entries for deleted or replaced files do not accumulate.
+		if (!entry.Used) continue;
+		WriteCacheString(out, entry.Path);
+		WriteCacheLong(out, (uint32_t)entry.Size);
+		WriteCacheLong(out, (uint32_t)(entry.Size >> 32));
+		WriteCacheLong(out, (uint32_t)entry.ModTime);
+		WriteCacheLong(out, (uint32_t)((uint64_t)entry.ModTime >> 32));
+		WriteCacheLong(out, entry.Kind);
+		WriteCacheLong(out, entry.Signature);
+		WriteCacheLong(out, (uint32_t)entry.Index);
+		WriteCacheString(out, entry.IWadInfo);
+		count++;
+	}
+	out[countpos] = (uint8_t)count;
+	out[countpos + 1] = (uint8_t)(count >> 8);
+	out[countpos + 2] = (uint8_t)(count >> 16);
+	out[countpos + 3] = (uint8_t)(count >> 24);
+
+	FString path = IdentCachePath(true);
+	FileWriter *fw = FileWriter::Open(path);
+	if (fw != nullptr)
+	{
+		if (fw->Write(out.Data(), out.Size()) != out.Size())
+		{
+			DPrintf(DMSG_WARNING, "Error saving IWAD cache to %s\n", path.GetChars());
+		}
+		delete fw;
+	}
 }
 
 //==========================================================================
@@ -489,22 +661,98 @@ void FIWadManager::AddIWADCandidates(const char *dir)
 
 void FIWadManager::ValidateIWADs()
 {
-	TArray<int> returns;
-	unsigned originalsize = mIWadInfos.Size();
+	bool usecache = !Args->CheckParm("-noiwadcache");
+	if (usecache) ReadIdentCache();
+
 	for (auto &p : mFoundWads)
 	{
 		int index;
 		auto x = strrchr(p.mFullPath, '.');
-		if (x != nullptr && (!stricmp(x, ".iwad") || !stricmp(x, ".ipk3") || !stricmp(x, ".ipk7")))
+		bool hasinfo = x != nullptr && (!stricmp(x, ".iwad") || !stricmp(x, ".ipk3") || !stricmp(x, ".ipk7"));
+
+		size_t size = 0;
+		time_t mtime = 0;
+		FIWadCacheEntry *entry = nullptr;
+		if (usecache && GetFileInfo(p.mFullPath, &size, &mtime))
 		{
-			index = CheckIWADInfo(p.mFullPath);
+			for (auto &e : mIdentCache)
+			{
+				if (e.Path == p.mFullPath)
+				{
+					entry = &e;
+					break;
+				}
+			}
+			if (entry == nullptr)
+			{
+				entry = &mIdentCache[mIdentCache.Push(FIWadCacheEntry())];
+				entry->Path = p.mFullPath;
+			}
+			else if (entry->Size != size || entry->ModTime != (int64_t)mtime || entry->Kind != (hasinfo ? FIWadCacheEntry::InfoLump : FIWadCacheEntry::Scanned))
+			{
+				// The file has changed since it was last identified.
+				entry->IWadInfo = "";
+				entry->Index = -1;
+				entry->Signature = 0;
+				entry->Kind = 0xff;
+			}
+			entry->Used = true;
+		}
+
+		if (hasinfo)
+		{
+			if (entry != nullptr && entry->Kind == FIWadCacheEntry::InfoLump)
+			{
+				index = AddIWADInfo(p.mFullPath, entry->IWadInfo.GetChars(), (int)entry->IWadInfo.Len());
+			}
+			else
+			{
+				FString infotext;
+				index = CheckIWADInfo(p.mFullPath, entry != nullptr ? &infotext : nullptr);
+				if (entry != nullptr)
+				{
+					// Failures are not remembered so that the error gets reported again.
+					entry->Used = index >= 0;
+					entry->Size = size;
+					entry->ModTime = mtime;
+					entry->Kind = FIWadCacheEntry::InfoLump;
+					entry->IWadInfo = infotext;
+					mIdentCacheChanged = true;
+				}
+			}
 		}
 		else
 		{
-			index = ScanIWAD(p.mFullPath);
+			uint32_t signature = entry != nullptr ? IWadInfoSignature() : 0;
+			if (entry != nullptr && entry->Kind == FIWadCacheEntry::Scanned && entry->Signature == signature)
+			{
+				index = entry->Index;
+				if (index >= (int)mIWadInfos.Size()) index = -1;
+			}
+			else
+			{
+				index = ScanIWAD(p.mFullPath);
+				if (entry != nullptr)
+				{
+					entry->Size = size;
+					entry->ModTime = mtime;
+					entry->Kind = FIWadCacheEntry::Scanned;
+					entry->Signature = signature;
+					entry->Index = index;
+					mIdentCacheChanged = true;
+				}
+			}
 		}
 		p.mInfoIndex = index;
 	}
+
+	if (usecache)
+	{
+		// Also rewrite the cache when entries went unused so that stale ones get dropped.
+		for (auto &e : mIdentCache) if (!e.Used) mIdentCacheChanged = true;
+		if (mIdentCacheChanged) WriteIdentCache();
+		mIdentCache.Clear();
+	}
 }
 
 //==========================================================================
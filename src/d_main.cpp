@@ -1300,6 +1300,76 @@ void D_DoomLoop ()
 	}
 }
 
+//==========================================================================
+//
+// D_BenchPlaysim
+//
+// Runs the playsim on the given map for a fixed number of tics as fast
+// as possible. Nothing gets drawn and sound is disabled, so this only
+// needs the dummy framebuffer V_InitScreen creates. Prints per-tic
+// wall time percentiles and a breakdown of the thinker counters.
+//
+//==========================================================================
+
+extern cycle_t ThinkCycles, ActionCycles, BotSupportCycles;
+
+static void D_BenchPlaysim (const char *mapname, int numtics)
+{
+	TArray<double> tictimes;
+	double thinktime = 0, actiontime = 0, bottime = 0;
+	cycle_t ticclock;
+
+	singletics = true;
+	NoWipe = 0;
+	startmap = mapname;
+	CheckWarpTransMap(startmap, true);
+	G_InitNew(startmap, false);
+
+	if (gamestate != GS_LEVEL)
+	{
+		I_FatalError("benchplaysim: Unable to start map %s", mapname);
+	}
+
+	tictimes.Reserve(numtics);
+	tictimes.Clear();
+	for (int i = 0; i < numtics && gamestate == GS_LEVEL; i++)
+	{
+		ticclock.Reset();
+		ticclock.Clock();
+		G_Ticker();
+		gametic++;
+		maketic++;
+		GC::CheckGC();
+		ticclock.Unclock();
+
+		tictimes.Push(ticclock.TimeMS());
+		thinktime += ThinkCycles.TimeMS();
+		actiontime += ActionCycles.TimeMS();
+		bottime += BotSupportCycles.TimeMS();
+	}
+
+	unsigned count = tictimes.Size();
+	if (count == 0)
+	{
+		I_FatalError("benchplaysim: No tics were run");
+	}
+
+	double total = 0;
+	for (auto t : tictimes) total += t;
+	std::sort(tictimes.begin(), tictimes.end());
+
+	auto percentile = [&](double p) { return tictimes[MIN(unsigned(p * count), count - 1)]; };
+
+	Printf("benchplaysim: %s, %u tics\n", startmap.GetChars(), count);
+	Printf("Tic time, ms: min %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f  avg %.3f\n",
+		tictimes[0], percentile(0.5), percentile(0.9), percentile(0.99), tictimes[count - 1], total / count);
+	Printf("Per tic, ms: think %.3f  action %.3f  botsupport %.3f  other %.3f\n",
+		thinktime / count, actiontime / count, bottime / count, (total - thinktime) / count);
+	Printf("Total %.1f ms (%.1f tics/sec)\n", total, count * 1000. / total);
+
+	throw CExitEvent(0);
+}
+
 //==========================================================================
 //
 // D_PageTicker
@@ -2025,6 +2095,12 @@ static void D_DoomInit()
 		rngseed = I_MakeRNGSeed();
 		use_staticrng = false;
 	}
+	if (!v && Args->CheckParm("-benchplaysim"))
+	{
+		// Benchmark runs must be repeatable.
+		rngseed = staticrngseed = 0;
+		use_staticrng = true;
+	}
 	srand(rngseed);
 		
 	FRandom::StaticClearRandom ();
@@ -3093,6 +3169,11 @@ static int D_DoomMain_Internal (void)
 		Printf("\n");
 	}
 
+	if (Args->CheckParm("-benchplaysim"))
+	{
+		nosound = true;
+	}
+
 	if (Args->CheckParm("-hashfiles"))
 	{
 		const char *filename = "fileinfo.txt";
@@ -3541,6 +3622,12 @@ static int D_DoomMain_Internal (void)
 				return 1337; // special exit
 			}
 
+			p = Args->CheckParm("-benchplaysim");
+			if (p && p < Args->NumArgs() - 2)
+			{
+				D_BenchPlaysim(Args->GetArg(p + 1), MAX(1, atoi(Args->GetArg(p + 2))));	// never returns
+			}
+
 			V_Init2();
 			twod->fullscreenautoaspect = gameinfo.fullscreenautoaspect;
 			// Initialize the size of the 2D drawer so that an attempt to access it outside the draw code won't crash.
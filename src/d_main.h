@@ -101,6 +101,25 @@ struct FFoundWadInfo
 	}
 };
 
+// Identification result for one IWAD candidate, remembered between launches.
+struct FIWadCacheEntry
+{
+	enum
+	{
+		Scanned,			// Index is the result of ScanIWAD for the definitions with the given Signature.
+		InfoLump,			// IWadInfo is the file's own IWADINFO lump.
+	};
+
+	FString Path;
+	uint64_t Size = 0;
+	int64_t ModTime = 0;
+	uint8_t Kind = Scanned;
+	uint32_t Signature = 0;
+	int Index = -1;
+	FString IWadInfo;
+	bool Used = false;
+};
+
 //==========================================================================
 //
 // IWAD identifier class
@@ -115,10 +134,16 @@ class FIWadManager
 	TArray<FString> mOrderNames;
 	TArray<FFoundWadInfo> mFoundWads;
 	TArray<int> mLumpsFound;
+	TArray<FIWadCacheEntry> mIdentCache;
+	bool mIdentCacheChanged = false;
 
 	void ParseIWadInfo(const char *fn, const char *data, int datasize, FIWADInfo *result = nullptr);
 	int ScanIWAD (const char *iwad);
-	int CheckIWADInfo(const char *iwad);
+	int CheckIWADInfo(const char *iwad, FString *infotext = nullptr);
+	int AddIWADInfo(const char *fn, const char *data, int datasize);
+	uint32_t IWadInfoSignature() const;
+	void ReadIdentCache();
+	void WriteIdentCache();
 	int IdentifyVersion (TArray<FString> &wadfiles, const char *iwad, const char *zdoom_wad, const char *optional_wad);
 	void CollectSearchPaths();
 	void AddIWADCandidates(const char *dir);
@@ -134,8 +134,8 @@ CUSTOM_CVAR(Int, r_maxparticles, 4000, CVAR_ARCHIVE | CVAR_NOINITCALL)
 {
 	if (self == 0)
 		self = 4000;
-	else if (self > 65535)
-		self = 65535;
+	else if (self > 500000)
+		self = 500000;
 	else if (self < 100)
 		self = 100;
 
@@ -2,6 +2,7 @@
 #define __P_BLOCKMAP_H
 
 #include "doomtype.h"
+#include "tarray.h"
 
 class AActor;
 
@@ -22,6 +23,16 @@ struct FBlockNode
 	static FBlockNode *FreeBlocks;
 };
 
+// The actors of a block, stored contiguously so that FBlockThingsIterator
+// can scan them linearly. This mirrors the FBlockNode chain of the block
+// in reverse, so linking in an actor, which prepends to the chain, only
+// needs to append here and the iteration order stays the same.
+struct FBlockActorEntry
+{
+	AActor *Me;
+	bool Spans;						// actor is linked into more than one block and needs to be checked for duplicates
+};
+
 // BLOCKMAP
 // Created from axis aligned bounding box
 // of the map, a rectangular array of
@@ -40,6 +51,7 @@ struct FBlockmap
 	double				bmaporgx;
 	double				bmaporgy;		// origin of block map
 	FBlockNode**		blocklinks; 	// for thing chains
+	TArray<FBlockActorEntry>* blockactors = nullptr;	// same as blocklinks, for iterating
 
 	// mapblocks are used to check movement
 	// against lines and things
@@ -75,6 +87,26 @@ struct FBlockmap
 
 	bool VerifyBlockMap(int count, unsigned numlines);
 
+	void AddActorEntry(int block, AActor *actor)
+	{
+		blockactors[block].Push({ actor, false });
+	}
+
+	// Returns the position the entry had so that it can be put back there.
+	int RemoveActorEntry(int block, AActor *actor)
+	{
+		auto &list = blockactors[block];
+		for (int i = list.Size() - 1; i >= 0; i--)
+		{
+			if (list[i].Me == actor)
+			{
+				list.Delete(i);
+				return i;
+			}
+		}
+		return -1;
+	}
+
 	void Clear()
 	{
 		if (blockmaplump != nullptr)
@@ -87,6 +119,11 @@ struct FBlockmap
 			delete[] blocklinks;
 			blocklinks = nullptr;
 		}
+		if (blockactors != nullptr)
+		{
+			delete[] blockactors;
+			blockactors = nullptr;
+		}
 	}
 
 	~FBlockmap()
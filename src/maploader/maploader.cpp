@@ -2639,6 +2639,7 @@ void MapLoader::LoadBlockMap (MapData * map)
 	count = Level->blockmap.bmapwidth*Level->blockmap.bmapheight;
 	Level->blockmap.blocklinks = new FBlockNode *[count];
 	memset (Level->blockmap.blocklinks, 0, count*sizeof(*Level->blockmap.blocklinks));
+	Level->blockmap.blockactors = new TArray<FBlockActorEntry>[count];
 	Level->blockmap.blockmap = Level->blockmap.blockmaplump+4;
 }
 
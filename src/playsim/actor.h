@@ -690,6 +690,7 @@ public:
 	bool CheckMeleeRange();
 
 	bool CheckNoDelay();
+	bool IsIdle();
 
 	virtual void BeginPlay();			// Called immediately after the actor is created
 	void CallBeginPlay();
@@ -965,6 +966,13 @@ public:
 	AActor			*snext, **sprev;	// links in sector (if needed)
 	DVector3		__Pos;		// double underscores so that it won't get used by accident. Access to this should be exclusively through the designated access functions.
 
+// movement state, kept together so that P_XYMovement and P_ZMovement
+// touch as few cache lines as possible.
+	DVector3		Vel;
+	double			radius, Height;		// for movement checking
+	double			floorz, ceilingz;	// closest together of contacted secs
+	double			dropoffz;		// killough 11/98: the lowest floor over all contacted Sectors.
+
 	DAngle			SpriteAngle;
 	DAngle			SpriteRotation;
 	DRotator		Angles;
@@ -994,7 +1002,6 @@ public:
 	ActorFlags7		flags7;			// WHO WANTS TO BET ON 8!?
 	ActorFlags8		flags8;			// I see your 8, and raise you a bet for 9.
 	double			Floorclip;		// value to use for floor clipping
-	double			radius, Height;		// for movement checking
 
 	DAngle			VisibleStartAngle;
 	DAngle			VisibleStartPitch;
@@ -1002,7 +1009,6 @@ public:
 	DAngle			VisibleEndPitch;
 
 	DVector3		OldRenderPos;
-	DVector3		Vel;
 	DVector2		SpriteOffset;
 	double			Speed;
 	double			FloatSpeed;
@@ -1012,8 +1018,6 @@ public:
 	struct sector_t	*Sector;
 	subsector_t *		subsector;
 	FSection *			section;
-	double			floorz, ceilingz;	// closest together of contacted secs
-	double			dropoffz;		// killough 11/98: the lowest floor over all contacted Sectors.
 
 	struct sector_t	*floorsector;
 	FTextureID		floorpic;			// contacted sec floorpic
@@ -42,12 +42,20 @@
 #include "v_text.h"
 #include "g_levellocals.h"
 #include "a_dynlight.h"
+#include "files.h"
+#include "i_time.h"
+#include "tflatmap.h"
 
+#if defined _MSC_VER && (defined _M_IX86 || defined _M_X64)
+#include <xmmintrin.h>
+#endif
 
-static int ThinkCount;
-static cycle_t ThinkCycles;
+
+static int ThinkCount, SleepCount;
+cycle_t ThinkCycles;
 extern cycle_t BotSupportCycles;
 extern cycle_t ActionCycles;
+extern cycle_t VMCycles[10];
 extern int BotWTG;
 
 IMPLEMENT_CLASS(DThinker, false, false)
@@ -55,6 +63,7 @@ IMPLEMENT_CLASS(DThinker, false, false)
 struct ProfileInfo
 {
 	int numcalls = 0;
+	double vmtime = 0;
 	cycle_t timer;
 
 	ProfileInfo()
@@ -63,10 +72,40 @@ struct ProfileInfo
 	}
 };
 
-static TMap<FName, ProfileInfo> Profiles;
+static TFlatMap<FName, ProfileInfo> Profiles;
 static unsigned int profilethinkers, profilelimit;
 DThinker *NextToThink;
 
+// Skip ticking actors for which AActor::Tick would not do anything.
+CVAR(Bool, sv_actorsleep, true, CVAR_SERVERINFO)
+
+// Continuous capture for profilethinkers_capture, written to a file once
+// the requested number of tics has been recorded.
+struct ProfileCaptureEntry
+{
+	FName className;
+	int numcalls;
+	double time;
+	double vmtime;
+};
+
+struct ProfileCaptureTic
+{
+	int tic;
+	uint64_t start;		// ns since the capture started
+	unsigned firstentry;
+	double time;
+	double vmtime;
+};
+
+static TArray<ProfileCaptureEntry> CaptureEntries;
+static TArray<ProfileCaptureTic> CaptureTics;
+static FString CaptureFile;
+static uint64_t CaptureStart;
+static int capturetics;
+
+static void WriteProfileCapture();
+
 //==========================================================================
 //
 //
@@ -88,6 +127,183 @@ void FThinkerCollection::Link(DThinker *thinker, int statnum)
 	list->AddTail(thinker);
 }
 
+//==========================================================================
+//
+// Prints the result of a profilethinkers run to the console.
+//
+//==========================================================================
+
+static void PrintProfile()
+{
+	struct SortedProfileInfo
+	{
+		const char* className;
+		int numcalls;
+		double time;
+	};
+
+	TArray<SortedProfileInfo> sorted;
+	sorted.Grow(Profiles.CountUsed());
+
+	auto it = TFlatMap<FName, ProfileInfo>::Iterator(Profiles);
+	TFlatMap<FName, ProfileInfo>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		sorted.Push({ pair->Key.GetChars(), pair->Value.numcalls, pair->Value.timer.TimeMS() });
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const SortedProfileInfo& left, const SortedProfileInfo& right)
+	{
+		switch (profilethinkers)
+		{
+		case 1: // by name, from A to Z
+			return stricmp(left.className, right.className) < 0;
+		case 2: // by name, from Z to A
+			return stricmp(right.className, left.className) < 0;
+		case 3: // number of calls, ascending
+			return left.numcalls < right.numcalls;
+		case 4: // number of calls, descending
+			return right.numcalls < left.numcalls;
+		case 5: // average time, ascending
+			return left.time / left.numcalls < right.time / right.numcalls;
+		case 6: // average time, descending
+			return right.time / right.numcalls < left.time / left.numcalls;
+		case 7: // total time, ascending
+			return left.time < right.time;
+		default: // total time, descending
+			return right.time < left.time;
+		}
+	});
+
+	Printf(TEXTCOLOR_YELLOW "Total, ms   Averg, ms   Calls   Actor class\n");
+	Printf(TEXTCOLOR_YELLOW "----------  ----------  ------  --------------------\n");
+
+	const unsigned count = MIN(profilelimit > 0 ? profilelimit : UINT_MAX, sorted.Size());
+
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const SortedProfileInfo& info = sorted[i];
+		Printf("%s%10.6f  %s%10.6f  %s%6d  %s%s\n",
+			profilethinkers >= 7 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.time,
+			profilethinkers == 5 || profilethinkers == 6 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.time / info.numcalls,
+			profilethinkers == 3 || profilethinkers == 4 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.numcalls,
+			profilethinkers == 1 || profilethinkers == 2 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.className);
+	}
+
+	profilethinkers = 0;
+}
+
+//==========================================================================
+//
+// Records this tic's per-class timings for profilethinkers_capture.
+//
+//==========================================================================
+
+static void CaptureProfileTic(uint64_t ticstart)
+{
+	ProfileCaptureTic &tic = CaptureTics[CaptureTics.Reserve(1)];
+	tic.tic = gametic;
+	tic.start = ticstart - CaptureStart;
+	tic.firstentry = CaptureEntries.Size();
+	tic.time = tic.vmtime = 0;
+
+	auto it = TFlatMap<FName, ProfileInfo>::Iterator(Profiles);
+	TFlatMap<FName, ProfileInfo>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		double time = pair->Value.timer.TimeMS();
+		CaptureEntries.Push({ pair->Key, pair->Value.numcalls, time, pair->Value.vmtime });
+		tic.time += time;
+		tic.vmtime += pair->Value.vmtime;
+	}
+
+	// Longest first, so that the trace viewer shows the expensive classes at the start of each tic.
+	std::sort(CaptureEntries.Data() + tic.firstentry, CaptureEntries.Data() + CaptureEntries.Size(), [](const ProfileCaptureEntry &left, const ProfileCaptureEntry &right)
+	{
+		return right.time < left.time;
+	});
+
+	if (--capturetics == 0)
+	{
+		WriteProfileCapture();
+	}
+}
+
+//==========================================================================
+//
+// Writes the captured tics either as CSV or as a JSON file in the
+// Chrome trace event format, which can be loaded into chrome://tracing
+// or Perfetto. Each class is shown as a slice of its tic, the VM and
+// total times are also output as counters.
+//
+//==========================================================================
+
+static void WriteProfileCapture()
+{
+	capturetics = 0;
+	if (CaptureTics.Size() == 0)
+	{
+		return;
+	}
+
+	FileWriter *fw = FileWriter::Open(CaptureFile);
+	if (fw == nullptr)
+	{
+		Printf(TEXTCOLOR_RED "Unable to write thinker profile to %s\n", CaptureFile.GetChars());
+	}
+	else
+	{
+		bool csv = CaptureFile.Len() > 4 && !stricmp(CaptureFile.GetChars() + CaptureFile.Len() - 4, ".csv");
+
+		if (csv)
+		{
+			fw->Printf("tic,class,calls,total_ms,vm_ms\n");
+		}
+		else
+		{
+			fw->Printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		}
+		for (unsigned t = 0; t < CaptureTics.Size(); t++)
+		{
+			const ProfileCaptureTic &tic = CaptureTics[t];
+			unsigned lastentry = t + 1 < CaptureTics.Size() ? CaptureTics[t + 1].firstentry : CaptureEntries.Size();
+			double ts = tic.start / 1000.;
+
+			if (!csv)
+			{
+				fw->Printf("%s{\"name\":\"Tic %d\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f},\n",
+					t == 0 ? "" : ",", tic.tic, ts, tic.time * 1000.);
+				fw->Printf("{\"name\":\"Thinkers\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"total_ms\":%.6f,\"vm_ms\":%.6f}}",
+					ts, tic.time, tic.vmtime);
+			}
+			for (unsigned e = tic.firstentry; e < lastentry; e++)
+			{
+				const ProfileCaptureEntry &entry = CaptureEntries[e];
+				if (csv)
+				{
+					fw->Printf("%d,%s,%d,%.6f,%.6f\n", tic.tic, entry.className.GetChars(), entry.numcalls, entry.time, entry.vmtime);
+				}
+				else
+				{
+					fw->Printf(",\n{\"name\":\"%s\",\"cat\":\"thinker\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f,"
+						"\"args\":{\"tic\":%d,\"calls\":%d,\"vm_ms\":%.6f}}",
+						entry.className.GetChars(), ts, entry.time * 1000., tic.tic, entry.numcalls, entry.vmtime);
+					ts += entry.time * 1000.;
+				}
+			}
+			if (!csv) fw->Printf("\n");
+		}
+		if (!csv)
+		{
+			fw->Printf("]}\n");
+		}
+		delete fw;
+		Printf("Wrote %u tics of thinker profiling to %s\n", CaptureTics.Size(), CaptureFile.GetChars());
+	}
+	CaptureTics.Reset();
+	CaptureEntries.Reset();
+}
+
 //==========================================================================
 //
 //
@@ -99,6 +315,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 	int i, count;
 
 	ThinkCount = 0;
+	SleepCount = 0;
 	ThinkCycles.Reset();
 	BotSupportCycles.Reset();
 	ActionCycles.Reset();
@@ -106,11 +323,12 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 
 	ThinkCycles.Clock();
 
-	if (!profilethinkers)
+	if (!profilethinkers && !capturetics)
 	{
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
+			if (i == STAT_DEFAULT) P_PrimeSightCache(Level);
 			Thinkers[i].TickThinkers(nullptr);
 		}
 
@@ -133,10 +351,13 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 	}
 	else
 	{
+		uint64_t ticstart = I_nsTime();
+
 		Profiles.Clear();
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
+			if (i == STAT_DEFAULT) P_PrimeSightCache(Level);
 			Thinkers[i].ProfileThinkers(nullptr);
 		}
 
@@ -165,63 +386,14 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 			prof.timer.Unclock();
 		}
 
-
-		struct SortedProfileInfo
+		if (capturetics)
 		{
-			const char* className;
-			int numcalls;
-			double time;
-		};
-
-		TArray<SortedProfileInfo> sorted;
-		sorted.Grow(Profiles.CountUsed());
-
-		auto it = TMap<FName, ProfileInfo>::Iterator(Profiles);
-		TMap<FName, ProfileInfo>::Pair *pair;
-		while (it.NextPair(pair))
-		{
-			sorted.Push({ pair->Key.GetChars(), pair->Value.numcalls, pair->Value.timer.TimeMS() });
+			CaptureProfileTic(ticstart);
 		}
-
-		std::sort(sorted.begin(), sorted.end(), [](const SortedProfileInfo& left, const SortedProfileInfo& right)
-		{
-			switch (profilethinkers)
-			{
-			case 1: // by name, from A to Z
-				return stricmp(left.className, right.className) < 0;
-			case 2: // by name, from Z to A
-				return stricmp(right.className, left.className) < 0;
-			case 3: // number of calls, ascending
-				return left.numcalls < right.numcalls;
-			case 4: // number of calls, descending
-				return right.numcalls < left.numcalls;
-			case 5: // average time, ascending
-				return left.time / left.numcalls < right.time / right.numcalls;
-			case 6: // average time, descending
-				return right.time / right.numcalls < left.time / left.numcalls;
-			case 7: // total time, ascending
-				return left.time < right.time;
-			default: // total time, descending
-				return right.time < left.time;
-			}
-		});
-
-		Printf(TEXTCOLOR_YELLOW "Total, ms   Averg, ms   Calls   Actor class\n");
-		Printf(TEXTCOLOR_YELLOW "----------  ----------  ------  --------------------\n");
-
-		const unsigned count = MIN(profilelimit > 0 ? profilelimit : UINT_MAX, sorted.Size());
-
-		for (unsigned i = 0; i < count; ++i)
+		if (profilethinkers)
 		{
-			const SortedProfileInfo& info = sorted[i];
-			Printf("%s%10.6f  %s%10.6f  %s%6d  %s%s\n",
-				profilethinkers >= 7 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.time,
-				profilethinkers == 5 || profilethinkers == 6 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.time / info.numcalls,
-				profilethinkers == 3 || profilethinkers == 4 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.numcalls,
-				profilethinkers == 1 || profilethinkers == 2 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.className);
+			PrintProfile();
 		}
-
-		profilethinkers = 0;
 	}
 
 	ThinkCycles.Unclock();
@@ -538,6 +710,41 @@ void FThinkerList::SaveList(FSerializer &arc)
 	}
 }
 
+//==========================================================================
+//
+// Thinkers are ticked in list order, which has nothing to do with where
+// they live in memory, so on big maps nearly every thinker is a cache miss.
+// Start loading the next one while the current one ticks. For actors the
+// first few cache lines contain the movement state (see AActor::__Pos).
+//
+//==========================================================================
+
+static inline void PrefetchThinker(DThinker *node)
+{
+	auto p = reinterpret_cast<const char *>(node);
+	for (int i = 0; i < 4; i++)
+	{
+#if defined _MSC_VER && (defined _M_IX86 || defined _M_X64)
+		_mm_prefetch(p + i * 64, _MM_HINT_T0);
+#elif defined __GNUC__
+		__builtin_prefetch(p + i * 64);
+#endif
+	}
+}
+
+//==========================================================================
+//
+// Only actors ever get OF_CanSleep, and only if they don't override Tick
+// in ZScript. See AActor::IsIdle for the rules.
+//
+//==========================================================================
+
+static inline bool IsSleeping(DThinker *node)
+{
+	return (node->ObjectFlags & (OF_CanSleep | OF_JustSpawned)) == OF_CanSleep && sv_actorsleep &&
+		static_cast<AActor *>(node)->IsIdle();
+}
+
 //==========================================================================
 //
 //
@@ -558,6 +765,7 @@ int FThinkerList::TickThinkers(FThinkerList *dest)
 	{
 		++count;
 		NextToThink = node->NextThinker;
+		PrefetchThinker(NextToThink);
 		if (node->ObjectFlags & OF_JustSpawned)
 		{
 			// Leave OF_JustSpawn set until after Tick() so the ticker can check it.
@@ -575,9 +783,16 @@ int FThinkerList::TickThinkers(FThinkerList *dest)
 
 		if (!(node->ObjectFlags & OF_EuthanizeMe))
 		{ // Only tick thinkers not scheduled for destruction
-			ThinkCount++;
-			node->CallTick();
-			node->ObjectFlags &= ~OF_JustSpawned;
+			if (IsSleeping(node))
+			{
+				SleepCount++;
+			}
+			else
+			{
+				ThinkCount++;
+				node->CallTick();
+				node->ObjectFlags &= ~OF_JustSpawned;
+			}
 			GC::CheckGC();
 		}
 		node = NextToThink;
@@ -604,6 +819,7 @@ int FThinkerList::ProfileThinkers(FThinkerList *dest)
 	{
 		++count;
 		NextToThink = node->NextThinker;
+		PrefetchThinker(NextToThink);
 		if (node->ObjectFlags & OF_JustSpawned)
 		{
 			// Leave OF_JustSpawn set until after Tick() so the ticker can check it.
@@ -621,14 +837,23 @@ int FThinkerList::ProfileThinkers(FThinkerList *dest)
 
 		if (!(node->ObjectFlags & OF_EuthanizeMe))
 		{ // Only tick thinkers not scheduled for destruction
-			ThinkCount++;
+			if (IsSleeping(node))
+			{
+				SleepCount++;
+			}
+			else
+			{
+				ThinkCount++;
 
-			auto &prof = Profiles[node->GetClass()->TypeName];
-			prof.numcalls++;
-			prof.timer.Clock();
-			node->CallTick();
-			prof.timer.Unclock();
-			node->ObjectFlags &= ~OF_JustSpawned;
+				auto &prof = Profiles[node->GetClass()->TypeName];
+				double vmstart = VMCycles[0].TimeMS();
+				prof.numcalls++;
+				prof.timer.Clock();
+				node->CallTick();
+				prof.timer.Unclock();
+				prof.vmtime += VMCycles[0].TimeMS() - vmstart;
+				node->ObjectFlags &= ~OF_JustSpawned;
+			}
 			GC::CheckGC();
 		}
 		node = NextToThink;
@@ -836,6 +1061,51 @@ CCMD(profilethinkers)
 //
 //==========================================================================
 
+CCMD(profilethinkers_capture)
+{
+	const int argc = argv.argc();
+
+	if (argc == 2 && !stricmp(argv[1], "stop"))
+	{
+		if (capturetics)
+		{
+			WriteProfileCapture();
+		}
+	}
+	else if (argc == 2 || argc == 3)
+	{
+		const int tics = atoi(argv[1]);
+		if (tics <= 0)
+		{
+			Printf("Number of tics must be positive\n");
+			return;
+		}
+		if (capturetics)
+		{
+			WriteProfileCapture();
+		}
+		CaptureFile = argc == 3 ? argv[2] : "thinkerprofile.json";
+		CaptureStart = I_nsTime();
+		capturetics = tics;
+		Printf("Capturing thinker profile for %d tics\n", tics);
+	}
+	else
+	{
+		Printf(
+			"Usage: profilethinkers_capture <tics> [filename]\n"
+			"       profilethinkers_capture stop\n\n"
+			"Records time, VM time and number of calls per class for every tic.\n"
+			"Files ending in .csv are written as CSV, everything else as a\n"
+			"Chrome trace event JSON file.\n");
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void DThinker::Tick ()
 {
 }
@@ -1004,6 +1274,6 @@ DThinker *FThinkerIterator::Next (bool exact)
 ADD_STAT (think)
 {
 	FString out;
-	out.Format ("Think time = %04.2f ms - %d thinkers, Action = %04.2f ms", ThinkCycles.TimeMS(), ThinkCount, ActionCycles.TimeMS());
+	out.Format ("Think time = %04.2f ms - %d thinkers, %d sleeping, Action = %04.2f ms", ThinkCycles.TimeMS(), ThinkCount, SleepCount, ActionCycles.TimeMS());
 	return out;
 }
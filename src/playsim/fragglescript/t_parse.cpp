@@ -284,6 +284,65 @@ char *FParser::GetTokens(char *s)
 }
 
 
+//==========================================================================
+//
+// GetCachedTokens
+//
+// Statements inside loops get run over and over again, so the result
+// of tokenizing them is kept in the script. Tokenizing only depends on
+// the script's text and its sections, and neither changes after
+// preprocessing.
+//
+//==========================================================================
+
+char *FParser::GetCachedTokens(char *s)
+{
+	char *data = Script->Data.Data();
+	if (s < data || s >= data + Script->len)
+	{
+		// included lumps are not part of the script's data.
+		return GetTokens(s);
+	}
+
+	int index = Script->MakeIndex(s);
+	FFsTokenCache *cache = Script->TokenCache.CheckKey(index);
+	if (cache != nullptr)
+	{
+		NumTokens = cache->Types.Size();
+		if (NumTokens > 0)
+		{
+			memcpy(Tokens[0], cache->Text.Data(), cache->Text.Size());
+			for (int i = 0; i < NumTokens; i++)
+			{
+				if (i > 0) Tokens[i] = Tokens[i - 1] + strlen(Tokens[i - 1]) + 1;
+				TokenType[i] = cache->Types[i];
+			}
+		}
+		LineStart = data + cache->LineStart;
+		Section = cache->Section;
+		BraceType = cache->BraceType;
+		Rover = data + cache->Next;
+		return Rover;
+	}
+
+	char *next = GetTokens(s);
+
+	cache = &Script->TokenCache.Insert(index, FFsTokenCache());
+	if (NumTokens > 0)
+	{
+		const char *last = Tokens[NumTokens - 1];
+		cache->Text.Resize(unsigned(last + strlen(last) + 1 - Tokens[0]));
+		memcpy(cache->Text.Data(), Tokens[0], cache->Text.Size());
+		cache->Types.Resize(NumTokens);
+		memcpy(cache->Types.Data(), TokenType, NumTokens * sizeof(TokenType[0]));
+	}
+	cache->LineStart = Script->MakeIndex(LineStart);
+	cache->Next = Script->MakeIndex(next);
+	cache->Section = Section;
+	cache->BraceType = BraceType;
+	return next;
+}
+
 //==========================================================================
 //
 // PrintTokens: add one character to the current token
@@ -346,7 +405,7 @@ void FParser::Run(char *rover, char *data, char *end)
 			PrevSection = Section; // store from prev. statement
 			
 			// get the line and tokens
-			GetTokens(Rover);
+			GetCachedTokens(Rover);
 			
 			if(!NumTokens)
 			{
@@ -122,6 +122,7 @@ char *DFsScript::SectionLoop(const DFsSection *sec)
 
 void DFsScript::ClearSections()
 {
+	TokenCache.Clear();
 	for(int i=0;i<SECTIONSLOTS;i++)
 	{
 		DFsSection * var = sections[i];
@@ -391,6 +392,7 @@ void DFsScript::DryRunScript(FLevelLocals *Level)
 void DFsScript::Preprocess(FLevelLocals *Level)
 {
 	len = (int)Data.Size() - 1;
+	TokenCache.Clear();
 	ProcessFindChar(Data.Data(), 0);  // fill in everything
 	DryRunScript(Level);
 }
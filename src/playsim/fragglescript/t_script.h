@@ -29,6 +29,7 @@
 #include "m_fixed.h"
 #include "actor.h"
 #include "engineerrors.h"
+#include "tflatmap.h"
 
 #ifdef _MSC_VER
 // This pragma saves 8kb of wasted code.
@@ -289,6 +290,22 @@ class CFsTerminator
 	int fill;
 };
 
+//==========================================================================
+//
+// A tokenized statement, see FParser::GetCachedTokens
+//
+//==========================================================================
+
+struct FFsTokenCache
+{
+	TArray<char> Text;			// the tokens, each one 0-terminated
+	TArray<tokentype_t> Types;
+	int LineStart;				// offsets into the script's data
+	int Next;
+	DFsSection *Section;
+	int BraceType;
+};
+
 //==========================================================================
 //
 // Scripts
@@ -334,6 +351,9 @@ public:
 	bool lastiftrue;     // haleyjd: whether last "if" statement was 
 	// true or false
 
+	// Tokenized statements by their offset in Data. This is not serialized.
+	TFlatMap<int, FFsTokenCache> TokenCache;
+
 	DFsScript();
 	void OnDestroy() override;
 	void Serialize(FSerializer &ar);
@@ -429,6 +449,7 @@ struct FParser
 
 	void NextToken();
 	char *GetTokens(char *s);
+	char *GetCachedTokens(char *s);
 	void PrintTokens();
 	void ErrorMessage(FString msg);
 
@@ -78,6 +78,7 @@
 #include "s_music.h"
 #include "v_video.h"
 #include "texturemanager.h"
+#include "i_time.h"
 
 	// P-codes for ACS scripts
 	enum
@@ -626,6 +627,10 @@ inline int PitchToACS(DAngle ang)
 	return int(ang.Normalized180().Degrees * (65536. / 360));
 }
 
+// Set with 'acsprofile start'. Timing scripts costs a clock read per call
+// and return, so it is only done on request.
+static bool ACSProfileTiming;
+
 struct CallReturn
 {
 	CallReturn(int pc, ScriptFunction *func, FBehavior *module, const ACSLocalVariables &locals, ACSLocalArrays *arrays, bool discard, unsigned int runaway)
@@ -6854,6 +6859,9 @@ int DLevelScript::RunScript()
 	const char *lookup;
 	int optstart = -1;
 	int temp;
+	const bool timing = ACSProfileTiming;
+	const uint64_t runstart = timing ? I_nsTime() : 0;
+	TArray<uint64_t> calltimes;	// entry times of the functions called in this run, only used when timing
 
 	while (state == SCRIPT_Running)
 	{
@@ -7175,6 +7183,7 @@ int DLevelScript::RunScript()
 				sp += i;
 				::new(&Stack[sp]) CallReturn(activeBehavior->PC2Ofs(pc), activeFunction,
 					activeBehavior, mylocals, localarrays, pcd == PCD_CALLDISCARD, runaway);
+				if (timing) calltimes.Push(I_nsTime());
 				sp += (sizeof(CallReturn) + sizeof(int) - 1) / sizeof(int);
 				pc = module->Ofs2PC (func->Address);
 				localarrays = &func->LocalArrays;
@@ -7204,7 +7213,9 @@ int DLevelScript::RunScript()
 				}
 				sp -= sizeof(CallReturn)/sizeof(int);
 				retsp = &Stack[sp];
-				activeBehavior->GetFunctionProfileData(activeFunction)->AddRun(runaway - ret->EntryInstrCount);
+				uint64_t calltime = 0;
+				if (timing && calltimes.Pop(calltime)) calltime = I_nsTime() - calltime;
+				activeBehavior->GetFunctionProfileData(activeFunction)->AddRun(runaway - ret->EntryInstrCount, calltime);
 				sp = int(locals.GetPointer() - &Stack[0]);
 				pc = ret->ReturnModule->Ofs2PC(ret->ReturnAddress);
 				activeFunction = ret->ReturnFunction;
@@ -10197,7 +10208,7 @@ scriptwait:
 		auto scriptptr = activeBehavior->GetScriptPtr(InModuleScriptNumber);
 		if (scriptptr != nullptr)
 		{
-			scriptptr->ProfileData.AddRun(runaway);
+			scriptptr->ProfileData.AddRun(runaway, timing ? I_nsTime() - runstart : 0);
 		}
 		else
 		{
@@ -10516,14 +10527,16 @@ ACSProfileInfo::ACSProfileInfo()
 void ACSProfileInfo::Reset()
 {
 	TotalInstr = 0;
+	TotalTime = 0;
 	NumRuns = 0;
 	MinInstrPerRun = UINT_MAX;
 	MaxInstrPerRun = 0;
 }
 
-void ACSProfileInfo::AddRun(unsigned int num_instr)
+void ACSProfileInfo::AddRun(unsigned int num_instr, uint64_t time)
 {
 	TotalInstr += num_instr;
+	TotalTime += time;
 	NumRuns++;
 	if (num_instr < MinInstrPerRun)
 	{
@@ -10615,6 +10628,14 @@ static int sort_by_avg(const void *a_, const void *b_)
 	return b_avg - a_avg;
 }
 
+static int sort_by_time(const void *a_, const void *b_)
+{
+	const ProfileCollector *a = (const ProfileCollector *)a_;
+	const ProfileCollector *b = (const ProfileCollector *)b_;
+
+	return b->ProfileData->TotalTime < a->ProfileData->TotalTime ? -1 : b->ProfileData->TotalTime > a->ProfileData->TotalTime ? 1 : 0;
+}
+
 static int sort_by_runs(const void *a_, const void *b_)
 {
 	const ProfileCollector *a = (const ProfileCollector *)a_;
@@ -10650,8 +10671,8 @@ static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 		limit = UINT_MAX;
 	}
 
-	Printf(TEXTCOLOR_YELLOW "Module       %-20s      Total    Runs     Avg     Min     Max\n", typelabels[functions]);
-	Printf(TEXTCOLOR_YELLOW "------------ -------------------- ---------- ------- ------- ------- -------\n");
+	Printf(TEXTCOLOR_YELLOW "Module       %-20s      Total    Runs     Avg     Min     Max    Time ms\n", typelabels[functions]);
+	Printf(TEXTCOLOR_YELLOW "------------ -------------------- ---------- ------- ------- ------- ------- ----------\n");
 	for (unsigned int i = 0; i < limit && i < profiles.Size(); ++i)
 	{
 		ProfileCollector *prof = &profiles[i];
@@ -10682,13 +10703,14 @@ static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 			mysnprintf(scriptname, sizeof(scriptname), "%s",
 				ScriptPresentation(prof->Module->GetScriptPtr(prof->Index)->Number).GetChars() + 7);
 		}
-		Printf("%-12s %-20s%11llu%8u%8u%8u%8u\n",
+		Printf("%-12s %-20s%11llu%8u%8u%8u%8u%11.3f\n",
 			modname, scriptname,
 			prof->ProfileData->TotalInstr,
 			prof->ProfileData->NumRuns,
 			unsigned(prof->ProfileData->TotalInstr / prof->ProfileData->NumRuns),
 			prof->ProfileData->MinInstrPerRun,
-			prof->ProfileData->MaxInstrPerRun
+			prof->ProfileData->MaxInstrPerRun,
+			prof->ProfileData->TotalTime / 1e6
 			);
 	}
 }
@@ -10701,10 +10723,11 @@ void ACSProfile(FLevelLocals *Level, FCommandLine &argv)
 		sort_by_min,
 		sort_by_max,
 		sort_by_avg,
-		sort_by_runs
+		sort_by_runs,
+		sort_by_time
 	};
-	static const char *sort_names[] = { "total", "min", "max", "avg", "runs" };
-	static const uint8_t sort_match_len[] = {   1,     2,     2,     1,      1 };
+	static const char *sort_names[] = { "total", "min", "max", "avg", "runs", "time" };
+	static const uint8_t sort_match_len[] = {   1,     2,     2,     1,      1,      1 };
 
 		TArray<ProfileCollector> ScriptProfiles, FuncProfiles;
 		long limit = 10;
@@ -10755,7 +10778,8 @@ void ACSProfile(FLevelLocals *Level, FCommandLine &argv)
 			{
 				Printf("Unknown option '%s'\n", argv[i]);
 				Printf("acsprofile clear : Reset profiling information\n");
-				Printf("acsprofile [total|min|max|avg|runs] [<limit>]\n");
+				Printf("acsprofile start|stop : Turn timing of scripts and functions on or off\n");
+				Printf("acsprofile [total|min|max|avg|runs|time] [<limit>]\n");
 				return;
 			}
 		}
@@ -10767,6 +10791,12 @@ void ACSProfile(FLevelLocals *Level, FCommandLine &argv)
 
 CCMD(acsprofile)
 {
+	if (argv.argc() > 1 && (stricmp(argv[1], "start") == 0 || stricmp(argv[1], "stop") == 0))
+	{
+		ACSProfileTiming = stricmp(argv[1], "start") == 0;
+		Printf("ACS timing %s\n", ACSProfileTiming ? "started" : "stopped");
+		return;
+	}
 	for (auto Level : AllLevels())
 	{
 		ACSProfile(Level, argv);
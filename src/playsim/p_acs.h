@@ -151,12 +151,13 @@ void P_ClearACSVars(bool);
 struct ACSProfileInfo
 {
 	unsigned long long TotalInstr;
+	uint64_t TotalTime;		// in nanoseconds
 	unsigned int NumRuns;
 	unsigned int MinInstrPerRun;
 	unsigned int MaxInstrPerRun;
 
 	ACSProfileInfo();
-	void AddRun(unsigned int num_instr);
+	void AddRun(unsigned int num_instr, uint64_t time);
 	void Reset();
 };
 
@@ -1,6 +1,7 @@
 #ifndef P_CHECKPOS_H
 #define P_CHECKPOS_H
 
+#include "tflatmap.h"
 
 //============================================================================
 //
@@ -33,7 +34,7 @@ struct FCheckPosition
 	AActor			*stepthing;
 	// [RH] These are used by PIT_CheckThing and P_XYMovement to apply
 	// ripping damage once per tic instead of once per move.
-	TMap<AActor*, bool> LastRipped;
+	TFlatMap<AActor*, bool> LastRipped;
 	bool			DoRipping;
 	bool			portalstep;
 	bool			dropoffisportal;
@@ -60,11 +60,11 @@ struct particle_t
 	float	fadestep;
 	float	alpha;
 	int		color;
-	uint16_t	tnext;
-	uint16_t	snext;
+	uint32_t	tnext;
+	uint32_t	snext;
 };
 
-const uint16_t NO_PARTICLE = 0xffff;
+const uint32_t NO_PARTICLE = 0xffffffff;
 
 void P_InitParticles(FLevelLocals *);
 void P_ClearParticles (FLevelLocals *Level);
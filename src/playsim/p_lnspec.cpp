@@ -2754,6 +2754,7 @@ FUNC(LS_Line_SetBlocking)
 	{
 		Level->lines[line].flags = (Level->lines[line].flags & ~clearflags) | setflags;
 	}
+	P_InvalidateSightCache();
 	return true;
 }
 
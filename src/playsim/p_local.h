@@ -279,7 +279,20 @@ enum ESightFlags
 	SF_IGNOREWATERBOUNDARY=8
 };
 
+// One looker/target pair for P_CheckSightBatch. 'result' is filled in by the call.
+struct FSightQuery
+{
+	AActor *looker;
+	AActor *target;
+	int flags;
+	bool result;
+};
+
+void	P_CheckSightBatch (TArray<FSightQuery> &queries, bool tracesonly = false);
+void	P_PrimeSightCache (FLevelLocals *Level);
+
 void	P_ResetSightCounters (bool full);
+void	P_InvalidateSightCache ();
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
 int	P_UsePuzzleItem (AActor *actor, int itemType);
@@ -408,6 +421,7 @@ int P_GetRadiusDamage(AActor *self, AActor *thing, int damage, int distance, int
 int	P_RadiusAttack (AActor *spot, AActor *source, int damage, int distance, 
 						FName damageType, int flags, int fulldamagedistance=0, FName species = NAME_None);
 
+extern unsigned secnodechanges;
 void	P_DelSeclist(msecnode_t *, msecnode_t *sector_t::*seclisthead);
 void	P_DelSeclist(portnode_t *, portnode_t *FLinePortal::*seclisthead);
 
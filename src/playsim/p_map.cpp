@@ -5716,6 +5716,65 @@ CUSTOM_CVAR(Float, splashfactor, 1.f, CVAR_SERVERINFO)
 		selfthrustscale = 1.f / self;
 }
 
+//==========================================================================
+//
+// Per-tic counters for the explosions and changesector stats. The
+// counters are collected per tic and the stats show those of the last
+// completed one.
+//
+//==========================================================================
+
+template<int N> struct FTicCounters
+{
+	int Tic = 0;
+	int Counts[N] = {}, LastCounts[N] = {};
+
+	void Add(int stat, int amount = 1)
+	{
+		if (Tic != gametic)
+		{
+			if (Tic == gametic - 1) memcpy(LastCounts, Counts, sizeof(Counts));
+			else memset(LastCounts, 0, sizeof(LastCounts));
+			memset(Counts, 0, sizeof(Counts));
+			Tic = gametic;
+		}
+		Counts[stat] += amount;
+	}
+
+	// returns nullptr if nothing got counted in the last completed tic.
+	const int *Last() const
+	{
+		return Tic == gametic - 1 ? Counts : Tic == gametic ? LastCounts : nullptr;
+	}
+};
+
+enum
+{
+	EXPSTAT_Explosions,
+	EXPSTAT_Candidates,
+	EXPSTAT_Rejected,
+	EXPSTAT_Targets,
+	EXPSTAT_Count
+};
+
+static FTicCounters<EXPSTAT_Count> ExplosionStats;
+
+ADD_STAT(explosions)
+{
+	FString out;
+	auto stats = ExplosionStats.Last();
+	if (stats == nullptr)
+	{
+		out = "0 explosions\n";
+	}
+	else
+	{
+		out.Format("%d explosions, %d candidates, %d rejected by range, %d targets\n",
+			stats[EXPSTAT_Explosions], stats[EXPSTAT_Candidates], stats[EXPSTAT_Rejected], stats[EXPSTAT_Targets]);
+	}
+	return out;
+}
+
 //==========================================================================
 //
 // P_GetRadiusDamage
@@ -5897,16 +5956,37 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 
 	P_GeometryRadiusAttack(bombspot, bombsource, bombdamage, bombdistance, bombmod, fulldamagedistance);
 
+	// Things whose box is farther away horizontally than the blast reaches cannot be
+	// affected, either by the old or the new damage code, so they can be dropped right
+	// away instead of going through the damage calculation. This does not apply to
+	// explosions that hurt everything in the blockmap range with 0 damage, or things
+	// with a negative damage factor, which turns the out of range damage around.
+	const bool rangecheck = !(bombspot->flags7 & MF7_FORCEZERORADIUSDMG);
+
+	ExplosionStats.Add(EXPSTAT_Explosions);
+
 	TArray<AActor*> targets;
 	int count = 0;
+	int candidates = 0, rejected = 0;
 	while ((it.Next(&cres)))
 	{
 		AActor *thing = cres.thing;
+		candidates++;
 		// Vulnerable actors can be damaged by radius attacks even if not shootable
 		// Used to emulate MBF's vulnerability of non-missile bouncers to explosions.
 		if (!((thing->flags & MF_SHOOTABLE) || (thing->flags6 & MF6_VULNERABLE)))
 			continue;
 
+		if (rangecheck && thing->RadiusDamageFactor >= 0)
+		{
+			DVector2 vec = bombspot->Vec2To(thing);
+			if (MAX(fabs(vec.X), fabs(vec.Y)) - thing->radius >= bombdistance)
+			{
+				rejected++;
+				continue;
+			}
+		}
+
 		// Boss spider and cyborg and Heretic's ep >= 2 bosses
 		// take no damage from concussion.
 		if (thing->flags3 & MF3_NORADIUSDMG && !(bombspot->flags4 & MF4_FORCERADIUSDMG))
@@ -5936,6 +6016,10 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 		targets.Push(thing);
 	}
 
+	ExplosionStats.Add(EXPSTAT_Candidates, candidates);
+	ExplosionStats.Add(EXPSTAT_Rejected, rejected);
+	ExplosionStats.Add(EXPSTAT_Targets, targets.Size());
+
 	for (AActor *thing : targets)
 	{
 		// Barrels always use the original code, since this makes
@@ -6629,6 +6713,87 @@ void PIT_CeilingRaise(AActor *thing, FChangePosition *cpos)
 	}
 }
 
+//=============================================================================
+//
+// P_CanSkipChangeSector
+//
+// With sv_fastchangesector, things that are neither resting on nor clipped
+// by the moving plane are not rechecked by P_ChangeSector. This is only
+// done for plain sectors where the plane's height is the same everywhere
+// and no 3D floors, 3D midtextures or linked portals can alter the result.
+//
+//=============================================================================
+
+CVAR(Bool, sv_fastchangesector, false, CVAR_SERVERINFO)
+
+static FTicCounters<2> ChangeSectorStats;	// checked, skipped
+
+static bool P_CanSkipChangeSector(sector_t *sector, int floorOrCeil)
+{
+	if (!sv_fastchangesector || floorOrCeil == 2) return false;
+
+	auto &plane = floorOrCeil == 0 ? sector->floorplane : sector->ceilingplane;
+	if (plane.isSlope() ||
+		sector->PortalIsLinked(floorOrCeil) ||
+		sector->e->XFloor.ffloors.Size() != 0 ||
+		sector->e->XFloor.attached.Size() != 0)
+	{
+		return false;
+	}
+	for (auto line : sector->Lines)
+	{
+		if (line->flags & ML_3DMIDTEX) return false;
+	}
+	return true;
+}
+
+//=============================================================================
+//
+// P_ChangeSectorUnaffected
+//
+// A thing can only be affected by a moving floor if that floor is or
+// becomes the highest floor below it or the lowest dropoff. Likewise for
+// ceilings. Both the old and the new height are checked, using the move
+// amount in both directions so that the direction of the move does not
+// matter.
+//
+// This only holds if the thing's floor or ceiling is a sector plane. A
+// thing resting on another actor gets its floorz from that actor, which
+// may itself be moved by the plane, so those always get the full check.
+//
+//=============================================================================
+
+static bool P_ChangeSectorUnaffected(AActor *thing, sector_t *sector, int floorOrCeil, double planez, double moveamt)
+{
+	if (thing->flags4 & MF4_ACTLIKEBRIDGE) return false;
+	if (thing->flags5 & MF5_MOVEWITHSECTOR) return false;
+	if (thing->flags2 & MF2_PASSMOBJ) return false;
+	if (thing->Z() < thing->floorz || thing->Top() > thing->ceilingz) return false;
+
+	if (floorOrCeil == 0)
+	{
+		if (thing->floorsector == sector || thing->floorsector == nullptr) return false;
+		if (thing->BlockingMobj != nullptr) return false;
+		if (thing->floorsector->floorplane.ZatPoint(thing) != thing->floorz) return false;
+		return planez + moveamt < thing->floorz && planez - moveamt > thing->dropoffz;
+	}
+	else
+	{
+		if (thing->ceilingsector == sector || thing->ceilingsector == nullptr) return false;
+		if (thing->ceilingsector->ceilingplane.ZatPoint(thing) != thing->ceilingz) return false;
+		return planez - moveamt > thing->ceilingz;
+	}
+}
+
+ADD_STAT(changesector)
+{
+	FString out;
+	auto stats = ChangeSectorStats.Last();
+	out.Format("%d things checked, %d skipped%s\n", stats ? stats[0] : 0, stats ? stats[1] : 0,
+		sv_fastchangesector ? "" : " (sv_fastchangesector is off)");
+	return out;
+}
+
 //=============================================================================
 //
 // P_ChangeSector	[RH] Was P_CheckSector in BOOM
@@ -6653,6 +6818,8 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 	cpos.sector = sector;
 	cpos.instant = instant;
 
+	P_InvalidateSightCache();
+
 	// Also process all sectors that have 3D floors transferred from the
 	// changed sector.
 	if (sector->e->XFloor.attached.Size() && floorOrCeil != 2)
@@ -6681,22 +6848,22 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 			if (sec->heightsec == sector) continue;
 
 			for (n = sec->touching_thinglist; n; n = n->m_snext) n->visited = false;
-			do
+			for (n = sec->touching_thinglist; n; )
 			{
-				for (n = sec->touching_thinglist; n; n = n->m_snext)
+				if (n->visited)
 				{
-					if (!n->visited)
-					{
-						n->visited = true;
-						if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-							(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
-						{
-							iterator(n->m_thing, &cpos);
-						}
-						break;
-					}
+					n = n->m_snext;
+					continue;
 				}
-			} while (n);
+				unsigned changes = secnodechanges;
+				n->visited = true;
+				if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
+					(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
+				{
+					iterator(n->m_thing, &cpos);
+				}
+				n = changes == secnodechanges ? n->m_snext : sec->touching_thinglist;
+			}
 			sec->CheckPortalPlane(!floorOrCeil);
 		}
 	}
@@ -6737,29 +6904,46 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 	// Things can arbitrarily be inserted and removed and it won't mess up.
 	//
 	// killough 4/7/98: simplified to avoid using complicated counter
+	//
+	// Restarting is only necessary if a thing list was actually changed while
+	// processing a thing. If not, every node before the current one is
+	// already marked, so the scan can just continue with the next node, which
+	// visits things in exactly the same order without the quadratic rescans.
 
 	// Mark all things invalid
 
 	for (n = sector->touching_thinglist; n; n = n->m_snext)
 		n->visited = false;
 
-	do
+	bool canskip = P_CanSkipChangeSector(sector, floorOrCeil);
+	double planez = floorOrCeil == 0 ? sector->floorplane.ZatPoint(sector->centerspot) : sector->ceilingplane.ZatPoint(sector->centerspot);
+
+	for (n = sector->touching_thinglist; n; )	// go through list
 	{
-		for (n = sector->touching_thinglist; n; n = n->m_snext)	// go through list
+		if (n->visited)
+		{
+			n = n->m_snext;
+			continue;
+		}
+		unsigned changes = secnodechanges;
+		n->visited = true; 							// mark thing as processed
+		if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
+			(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
 		{
-			if (!n->visited)								// unprocessed thing found
+			if (canskip && P_ChangeSectorUnaffected(n->m_thing, sector, floorOrCeil, planez, cpos.moveamt))
 			{
-				n->visited = true; 							// mark thing as processed
-				if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-					(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
-				{
-					iterator(n->m_thing, &cpos);		 			// process it
-					if (iterator2 != NULL) iterator2(n->m_thing, &cpos);
-				}
-				break;										// exit and start over
+				ChangeSectorStats.Add(1);
+			}
+			else
+			{
+				iterator(n->m_thing, &cpos);		 			// process it
+				if (iterator2 != NULL) iterator2(n->m_thing, &cpos);
+				ChangeSectorStats.Add(0);
 			}
 		}
-	} while (n);	// repeat from scratch until all things left are marked valid
+		// start over only if some thing list got modified.
+		n = changes == secnodechanges ? n->m_snext : sector->touching_thinglist;
+	}
 
 	if (floorOrCeil != 2) sector->CheckPortalPlane(floorOrCeil);	// check for portal obstructions after everything is done.
 
@@ -340,6 +340,7 @@ void AActor::UnlinkFromWorld (FLinkContext *ctx)
 				block->NextActor->PrevActor = block->PrevActor;
 			}
 			*(block->PrevActor) = block->NextActor;
+			Level->blockmap.RemoveActorEntry(block->BlockIndex, this);
 			FBlockNode *next = block->NextBlock;
 			block->Release ();
 			block = next;
@@ -545,6 +546,7 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 						}
 						node->PrevActor = link;
 						*link = node;
+						Level->blockmap.AddActorEntry(node->BlockIndex, this);
 
 						// Link in to actor
 						node->PrevBlock = alink;
@@ -555,6 +557,19 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 				}
 			}
 		}
+
+		// Actors in more than one block need to be filtered for duplicates by FBlockThingsIterator.
+		if (BlockNode != nullptr && BlockNode->NextBlock != nullptr)
+		{
+			for (auto node = BlockNode; node != nullptr; node = node->NextBlock)
+			{
+				auto &list = Level->blockmap.blockactors[node->BlockIndex];
+				for (int i = list.Size() - 1; i >= 0 && list[i].Me == this; i--)
+				{
+					list[i].Spans = true;
+				}
+			}
+		}
 	}
 	// Portal links cannot be done unless the level is fully initialized.
 	if (!spawningmapthing) UpdateRenderSectorList();
@@ -896,6 +911,8 @@ FBlockThingsIterator::FBlockThingsIterator(FLevelLocals *l)
 	miny = maxy = 0;
 	ClearHash();
 	block = NULL;
+	blockpos = 0;
+	lastactor = nullptr;
 }
 
 FBlockThingsIterator::FBlockThingsIterator(FLevelLocals *l, int _minx, int _miny, int _maxx, int _maxy)
@@ -943,9 +960,11 @@ void FBlockThingsIterator::StartBlock(int x, int y)
 {
 	curx = x;
 	cury = y;
+	lastactor = nullptr;
 	if (Level->blockmap.isValidBlock(x, y))
 	{
-		block = Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
+		block = &Level->blockmap.blockactors[y*Level->blockmap.bmapwidth + x];
+		blockpos = block->Size();
 	}
 	else
 	{
@@ -979,14 +998,33 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 	{
 		while (block != NULL)
 		{
-			AActor *me = block->Me;
-			FBlockNode *mynode = block;
 			HashEntry *entry;
 			int i;
 
-			block = block->NextActor;
+			// The caller may have linked or unlinked actors in this block since the last call.
+			// Linking appends to the list which does not affect the unvisited part, but unlinking
+			// an unvisited actor moves the visited ones down, so find the last returned one again.
+			if (lastactor != nullptr && ((unsigned)blockpos >= block->Size() || (*block)[blockpos].Me != lastactor))
+			{
+				for (i = MIN<int>(blockpos, block->Size()) - 1; i >= 0; i--)
+				{
+					if ((*block)[i].Me == lastactor)
+					{
+						blockpos = i;
+						break;
+					}
+				}
+			}
+			if (blockpos <= 0)
+			{
+				break;
+			}
+
+			auto &blockentry = (*block)[--blockpos];
+			AActor *me = lastactor = blockentry.Me;
+
 			// Don't recheck things that were already checked
-			if (mynode->NextBlock == NULL && mynode->PrevBlock == &me->BlockNode)
+			if (!blockentry.Spans)
 			{ // This actor doesn't span blocks, so we know it can only ever be checked once.
 				return me;
 			}
@@ -10,6 +10,7 @@
 
 extern int validcount;
 struct FBlockNode;
+struct FBlockActorEntry;
 
 struct divline_t
 {
@@ -286,7 +287,9 @@ class FBlockThingsIterator
 
 	int curx, cury;
 
-	FBlockNode *block;
+	TArray<FBlockActorEntry> *block;
+	int blockpos;			// entries are scanned from the end of the list
+	AActor *lastactor;
 
 	int Buckets[32];
 
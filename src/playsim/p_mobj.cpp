@@ -99,6 +99,7 @@
 #include "actorinlines.h"
 #include "a_dynlight.h"
 #include "fragglescript/t_fs.h"
+#include "types.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -3555,6 +3556,74 @@ DEFINE_ACTION_FUNCTION(AActor, CheckPortalTransition)
 	return 0;
 }
 
+//==========================================================================
+//
+// The thinker loop may only skip actors whose Tick is this one, because
+// it cannot know what a ZScript override would do.
+//
+//==========================================================================
+
+static bool HasNativeTick(AActor *self)
+{
+	IFVIRTUALPTR(self, DThinker, Tick)
+	{
+		return !!(func->VarFlags & VARF_Native);
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// AActor :: IsIdle
+//
+// Returns true if calling Tick right now would not change anything.
+// Decorations, corpses and items lying around spend most of their life
+// like this, so the thinker loop can skip them (see sv_actorsleep).
+// Every check here mirrors a part of Tick, so skipping the call cannot
+// affect the game's outcome. Whatever wakes the actor up, like damage,
+// thrust or a state change, will make one of them fail again.
+//
+//==========================================================================
+
+bool AActor::IsIdle()
+{
+	// The state never advances and there is nothing to respawn.
+	if (tics != -1 || (flags7 & MF7_HANDLENODELAY) || (flags5 & MF5_ALWAYSRESPAWN)) return false;
+	if ((flags3 & MF3_ISMONSTER) && !(flags2 & MF2_DORMANT) && !(flags5 & MF5_NEVERRESPAWN) && G_SkillProperty(SKILLP_Respawn)) return false;
+
+	// Nothing that gets processed every tic.
+	if (player != nullptr || Inventory != nullptr || Sector == nullptr) return false;
+	if (!Vel.isZero() || (flags6 & MF6_BOSSCUBE) || (flags8 & MF8_INSCROLLSEC)) return false;
+
+	// Neither portal transitions nor the render lists need to be updated.
+	if (!Sector->PortalBlocksMovement(sector_t::ceiling) || !Sector->PortalBlocksMovement(sector_t::floor)) return false;
+	if (!(flags & MF_NOSECTOR) && (touching_lineportallist != nullptr || touching_sectorportallist != nullptr || Level->PortalBlockmap.containsLines)) return false;
+
+	if (flags5 & MF5_NOINTERACTION)
+	{
+		return !!(flags & MF_NOBLOCKMAP);
+	}
+
+	if ((effects & (FX_ROCKET | FX_GRENADE | FX_VISIBILITYPULSE)) || (flags & (MF_STEALTH | MF_MISSILE | MF_SKULLFLY))) return false;
+	if ((flags4 & (MF4_VFRICTION | MF4_SCROLLMOVE)) || (flags2 & (MF2_WINDTHRUST | MF2_BLASTED))) return false;
+	if ((flags6 & MF6_TOUCHY) && !(flags6 & MF6_ARMED)) return false;
+	if (Level->BotInfo.botnum && !demoplayback && ((flags & MF_SPECIAL) || (flags3 & MF3_ISMONSTER))) return false;
+	if (BlockingMobj != nullptr || BlockingFloor != nullptr || BlockingCeiling != nullptr || Blocking3DFloor != nullptr) return false;
+	if (PoisonDurationReceived) return false;
+
+	// Resting on a flat floor without falling, sliding or crashing.
+	if (Z() != floorz) return false;
+	if ((flags & MF_SOLID) && !(flags & (MF_NOCLIP | MF_NOGRAVITY | MF_NOBLOCKMAP)) &&
+		(floorsector == nullptr || floorsector->floorplane.isSlope() || floorsector->e->XFloor.ffloors.Size() > 0)) return false;
+	if (!(flags6 & MF6_DONTCORPSE) && ((flags & MF_CORPSE) || (flags6 & MF6_KILLED)) && !(flags3 & MF3_CRASHED) && !(flags & MF_ICECORPSE)) return false;
+
+	// Not in any water.
+	if (waterlevel != 0 || boomwaterlevel != 0) return false;
+	if ((Sector->MoreFlags & SECMF_UNDERWATER) || Sector->GetHeightSec() != nullptr || Sector->e->XFloor.ffloors.Size() > 0) return false;
+
+	return true;
+}
+
 //
 // P_MobjThinker
 //
@@ -3588,6 +3657,11 @@ void AActor::Tick ()
 		return;
 	}
 
+	if (!(ObjectFlags & OF_CanSleep) && HasNativeTick(this))
+	{
+		ObjectFlags |= OF_CanSleep;
+	}
+
 	if (flags5 & MF5_NOINTERACTION)
 	{
 		// only do the minimally necessary things here to save time:
@@ -37,6 +37,10 @@
 msecnode_t *headsecnode = nullptr;
 FMemArena secnodearena;
 
+// Bumped whenever a node is taken from or returned to the freelist, so that
+// P_ChangeSector can tell if a sector's thing list was modified under it.
+unsigned secnodechanges;
+
 //=============================================================================
 //
 // P_GetSecnode
@@ -50,6 +54,7 @@ msecnode_t *P_GetSecnode()
 {
 	msecnode_t *node;
 
+	secnodechanges++;
 	if (headsecnode)
 	{
 		node = headsecnode;
@@ -72,6 +77,7 @@ msecnode_t *P_GetSecnode()
 
 void P_PutSecnode(msecnode_t *node)
 {
+	secnodechanges++;
 	node->m_snext = headsecnode;
 	headsecnode = node;
 }
@@ -36,10 +36,18 @@
 
 #include "g_levellocals.h"
 #include "actorinlines.h"
+#include "parallel_for.h"
+
+#include <thread>
 
 static FRandom pr_botchecksight ("BotCheckSight");
 static FRandom pr_checksight ("CheckSight");
 
+// Remembers trace results between tics as long as no geometry changes.
+// Changes made by scripts that write line or sector properties directly
+// cannot be detected, which is why this is off by default.
+CVAR(Bool, sv_sightcache, false, CVAR_SERVERINFO)
+
 /*
 ==============================================================================
 
@@ -51,8 +59,9 @@ This uses specialized forms of the maputils routines for optimized performance
 */
 
 // Performance meters
-static int sightcounts[6];
 static cycle_t SightCycles;
+static int SightCacheEpoch = 1;
+static int SightCacheInvalidations;
 static cycle_t MaxSightCycles;
 
 enum
@@ -86,13 +95,88 @@ struct SightTask
 	int portalgroup;
 };
 
+//==========================================================================
+//
+// Sight cache entries are looked up by the subsectors of both actors
+// but only count as a hit if the complete input to the trace matches.
+// Idle monsters and players standing still hit the same entry every tic.
+//
+//==========================================================================
+
+struct FSightCacheEntry
+{
+	int epoch;
+	int flags;
+	FLevelLocals *Level;
+	DVector3 lookerpos;
+	DVector3 targetpos;
+	double lookerheight;
+	double targetheight;
+	bool result;
+
+	bool Matches(AActor *t1, AActor *t2, int f) const
+	{
+		return epoch == SightCacheEpoch && Level == t1->Level && flags == f &&
+			lookerpos == t1->Pos() && targetpos == t2->Pos() &&
+			lookerheight == t1->Height && targetheight == t2->Height;
+	}
+};
 
-static TArray<intercept_t> intercepts (128);
-static TArray<SightTask> portals(32);
+enum { SIGHTCACHE_SIZE = 4096 };
+
+//==========================================================================
+//
+// Scratch state for sight checks. P_CheckSight uses a single static
+// instance, batched checks get one per worker so that they can run
+// concurrently. Lines and polyobjects are marked in private arrays
+// instead of through the global validcount.
+//
+//==========================================================================
+
+struct FSightContext
+{
+	TArray<intercept_t> intercepts;
+	TArray<SightTask> portals;
+	TArray<int> linechecked;
+	TArray<int> polychecked;
+	int checkcount = 0;
+	int counts[6] = {};
+	TArray<FSightCacheEntry> cache;
+	int cachehits = 0;
+	int cachemisses = 0;
+
+	FSightCacheEntry *FindCacheEntry(AActor *t1, AActor *t2, int flags)
+	{
+		if (cache.Size() == 0)
+		{
+			cache.Resize(SIGHTCACHE_SIZE);
+			memset(cache.Data(), 0, cache.Size() * sizeof(FSightCacheEntry));
+		}
+		unsigned hash = t1->subsector->Index() * 0x9E3779B1u ^ t2->subsector->Index() * 0x85EBCA6Bu ^ flags;
+		return &cache[(hash ^ (hash >> 15)) & (SIGHTCACHE_SIZE - 1)];
+	}
+
+	void Prepare(FLevelLocals *Level)
+	{
+		if (linechecked.Size() != Level->lines.Size() || polychecked.Size() != Level->Polyobjects.Size() || checkcount == INT_MAX)
+		{
+			linechecked.Resize(Level->lines.Size());
+			polychecked.Resize(Level->Polyobjects.Size());
+			memset(linechecked.Data(), 0, linechecked.Size() * sizeof(int));
+			memset(polychecked.Data(), 0, polychecked.Size() * sizeof(int));
+			checkcount = 0;
+		}
+	}
+};
+
+static FSightContext MainSightContext;
 
 class SightCheck
 {
 	FLevelLocals *Level;
+	FSightContext &ctx;
+	TArray<intercept_t> &intercepts;
+	TArray<SightTask> &portals;
 	DVector3 sightstart;
 	DVector2 sightend;
 	double Startfrac;
@@ -117,7 +201,8 @@ class SightCheck
 	bool LineBlocksSight(line_t *ld);
 
 public:
-	SightCheck(FLevelLocals *l)
+	SightCheck(FLevelLocals *l, FSightContext &context)
+		: ctx(context), intercepts(context.intercepts), portals(context.portals)
 	{
 		Level = l;
 	}
@@ -434,11 +519,12 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 {
 	divline_t dl;
 
-	if (ld->validcount == validcount)
+	int &checked = ctx.linechecked[ld->Index()];
+	if (checked == ctx.checkcount)
 	{
 		return true;
 	}
-	ld->validcount = validcount;
+	checked = ctx.checkcount;
 	if (P_PointOnDivlineSide (ld->v1->fPos(), &Trace) ==
 		P_PointOnDivlineSide (ld->v2->fPos(), &Trace))
 	{
@@ -456,7 +542,7 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 		if (LineBlocksSight(ld)) return false;
 	}
 
-	sightcounts[3]++;
+	ctx.counts[3]++;
 	// store the line for later intersection testing
 	intercept_t newintercept;
 	newintercept.isaline = true;
@@ -495,9 +581,10 @@ int SightCheck::P_SightBlockLinesIterator (int x, int y)
 	{
 		if (polyLink->polyobj)
 		{ // only check non-empty links
-			if (polyLink->polyobj->validcount != validcount)
+			int &checked = ctx.polychecked[int(polyLink->polyobj - Level->Polyobjects.Data())];
+			if (checked != ctx.checkcount)
 			{
-				polyLink->polyobj->validcount = validcount;
+				checked = ctx.checkcount;
 				for (i = 0; i < polyLink->polyobj->Linedefs.Size(); i++)
 				{
 					if (!P_SightCheckLine(polyLink->polyobj->Linedefs[i]))
@@ -627,7 +714,7 @@ bool SightCheck::P_SightPathTraverse ()
 	int mapx, mapy, mapxstep, mapystep;
 	int count;
 
-	validcount++;
+	ctx.checkcount++;
 	intercepts.Clear ();
 	x1 = sightstart.X + Startfrac * Trace.dx;
 	y1 = sightstart.Y + Startfrac * Trace.dy;
@@ -760,7 +847,7 @@ bool SightCheck::P_SightPathTraverse ()
 		itres = P_SightBlockLinesIterator(mapx, mapy);
 		if (itres == 0)
 		{
-			sightcounts[1]++;
+			ctx.counts[1]++;
 			return false;	// early out
 		}
 
@@ -771,7 +858,7 @@ bool SightCheck::P_SightPathTraverse ()
 		switch (((xs_FloorToInt(yintercept) == mapy) << 1) | (xs_FloorToInt(xintercept) == mapx))
 		{
 		case 0:		// neither xintercept nor yintercept match!
-sightcounts[5]++;
+ctx.counts[5]++;
 			// Continuing won't make things any better, so we might as well stop right here
 			return false;
 
@@ -790,7 +877,7 @@ sightcounts[5]++;
 			break;
 
 		case 3:		// xintercept and yintercept both match
-			sightcounts[4]++;
+			ctx.counts[4]++;
 			// The trace is exiting a block through its corner. Not only does the block
 			// being entered need to be checked (which will happen when this loop
 			// continues), but the other two blocks adjacent to the corner also need to
@@ -798,7 +885,7 @@ sightcounts[5]++;
 			if (!P_SightBlockLinesIterator (mapx + mapxstep, mapy) ||
 				!P_SightBlockLinesIterator (mapx, mapy + mapystep))
 			{
-sightcounts[1]++;
+ctx.counts[1]++;
 				return false;
 			}
 			xintercept += xstep;
@@ -817,7 +904,7 @@ sightcounts[1]++;
 //
 // couldn't early out, so go through the sorted list
 //
-sightcounts[2]++;
+ctx.counts[2]++;
 
 	bool traverseres = P_SightTraverseIntercepts ( );
 	if (itres == -1) return false;	// if the iterator had an early out there was no line of sight. The traverser was only called to collect more portals.
@@ -825,30 +912,20 @@ sightcounts[2]++;
 	return traverseres;
 }
 
-/*
-=====================
-=
-= P_CheckSight
-=
-= Returns true if a straight line between t1 and t2 is unobstructed
-= look from eyes of t1 to any part of t2
-=
-= killough 4/20/98: cleaned up, made to use new LOS struct
-=
-=====================
-*/
+//==========================================================================
+//
+// SightPrecheck
+//
+// The cheap rejection tests of P_CheckSight. This is also where the
+// random number generator gets called, so it must always run on the
+// main thread and in order.
+//
+// Returns 0 or 1 if this is conclusive and -1 if a trace is needed.
+//
+//==========================================================================
 
-int P_CheckSight (AActor *t1, AActor *t2, int flags)
+static int SightPrecheck(AActor *t1, AActor *t2, int flags)
 {
-	SightCycles.Clock();
-
-	bool res;
-
-	if (t1 == nullptr || t2 == nullptr)
-	{
-		return false;
-	}
-
 	auto s1 = t1->Sector;
 	auto s2 = t2->Sector;
 	//
@@ -856,9 +933,8 @@ int P_CheckSight (AActor *t1, AActor *t2, int flags)
 	//
 	if (!t1->Level->CheckReject(s1, s2))
 	{
-sightcounts[0]++;
-		res = false;			// can't possibly be connected
-		goto done;
+MainSightContext.counts[0]++;
+		return false;			// can't possibly be connected
 	}
 
 //
@@ -870,8 +946,7 @@ sightcounts[0]++;
 	{ // small chance of an attack being made anyway
 		if ((t1->Level->BotInfo.m_Thinking ? pr_botchecksight() : pr_checksight()) > 50)
 		{
-			res = false;
-			goto done;
+			return false;
 		}
 	}
 
@@ -891,69 +966,313 @@ sightcounts[0]++;
 			  (t2->Z() >= s2->heightsec->ceilingplane.ZatPoint(t2) &&
 			   t1->Top() <= s2->heightsec->ceilingplane.ZatPoint(t1)))))
 		{
-			res = false;
-			goto done;
+			return false;
 		}
 	}
+	return -1;
+}
 
-	// An unobstructed LOS is possible.
-	// Now look from eyes of t1 to any part of t2.
+//==========================================================================
+//
+// SightTrace
+//
+// Looks from the eyes of t1 to any part of t2. This only reads level
+// data and only writes to the passed context.
+//
+//==========================================================================
+
+static bool SightTrace(FSightContext &ctx, AActor *t1, AActor *t2, int flags)
+{
+	bool res;
+	FSightCacheEntry *entry = nullptr;
 
-	validcount++;
-	portals.Clear();
+	if (sv_sightcache)
 	{
-		sector_t *sec;
-		double lookheight = t1->Z() + t1->Height*0.75;
-		t1->GetPortalTransition(lookheight, &sec);
+		entry = ctx.FindCacheEntry(t1, t2, flags);
+		if (entry->Matches(t1, t2, flags))
+		{
+			ctx.cachehits++;
+			return entry->result;
+		}
+		ctx.cachemisses++;
+	}
+
+	ctx.Prepare(t1->Level);
+	ctx.portals.Clear();
 
-		double bottomslope = t2->Z() - lookheight;
-		double topslope = bottomslope + t2->Height;
-		SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
+	sector_t *sec;
+	double lookheight = t1->Z() + t1->Height*0.75;
+	t1->GetPortalTransition(lookheight, &sec);
 
+	double bottomslope = t2->Z() - lookheight;
+	double topslope = bottomslope + t2->Height;
+	SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
 
-		SightCheck s(t1->Level);
-		s.init(t1, t2, sec, &task, flags);
-		res = s.P_SightPathTraverse ();
-		if (!res)
+
+	SightCheck s(t1->Level, ctx);
+	s.init(t1, t2, sec, &task, flags);
+	res = s.P_SightPathTraverse ();
+	if (!res)
+	{
+		double dist = t1->Distance2D(t2);
+		for (unsigned i = 0; i < ctx.portals.Size(); i++)
 		{
-			double dist = t1->Distance2D(t2);
-			for (unsigned i = 0; i < portals.Size(); i++)
+			ctx.portals[i].Frac += 1 / dist;
+			s.init(t1, t2, NULL, &ctx.portals[i], flags);
+			if (s.P_SightPathTraverse())
 			{
-				portals[i].Frac += 1 / dist;
-				s.init(t1, t2, NULL, &portals[i], flags);
-				if (s.P_SightPathTraverse())
-				{
-					res = true;
-					break;
-				}
+				res = true;
+				break;
 			}
 		}
 	}
 
-done:
+	if (entry != nullptr)
+	{
+		*entry = { SightCacheEpoch, flags, t1->Level, t1->Pos(), t2->Pos(), t1->Height, t2->Height, res };
+	}
+	return res;
+}
+
+/*
+=====================
+=
+= P_CheckSight
+=
+= Returns true if a straight line between t1 and t2 is unobstructed
+= look from eyes of t1 to any part of t2
+=
+= killough 4/20/98: cleaned up, made to use new LOS struct
+=
+=====================
+*/
+
+int P_CheckSight (AActor *t1, AActor *t2, int flags)
+{
+	if (t1 == nullptr || t2 == nullptr)
+	{
+		return false;
+	}
+
+	SightCycles.Clock();
+
+	int res = SightPrecheck(t1, t2, flags);
+	if (res < 0)
+	{
+		// An unobstructed LOS is possible.
+		res = SightTrace(MainSightContext, t1, t2, flags);
+	}
+
 	SightCycles.Unclock();
 	return res;
 }
 
+//==========================================================================
+//
+// P_CheckSightBatch
+//
+// Performs P_CheckSight for a list of looker/target pairs. The rejection
+// tests run in order on the calling thread so the random number sequence
+// is the same as with individual P_CheckSight calls, then the remaining
+// traces are spread over worker threads. Each query's result is written
+// back into the query itself, so the outcome does not depend on how the
+// work was split up.
+//
+// With 'tracesonly' the rejection tests are skipped and the results are
+// only the traced line of sight. This is used to fill the sight cache
+// ahead of time, where it is skipped for pairs that are already cached.
+//
+//==========================================================================
+
+void P_CheckSightBatch (TArray<FSightQuery> &queries, bool tracesonly)
+{
+	TArray<unsigned> pending;
+
+	SightCycles.Clock();
+
+	for (unsigned i = 0; i < queries.Size(); i++)
+	{
+		auto &q = queries[i];
+		if (q.looker == nullptr || q.target == nullptr)
+		{
+			q.result = false;
+			continue;
+		}
+		if (tracesonly)
+		{
+			if (!sv_sightcache) pending.Push(i);
+			else
+			{
+				auto entry = MainSightContext.FindCacheEntry(q.looker, q.target, q.flags);
+				if (entry->Matches(q.looker, q.target, q.flags)) q.result = entry->result;
+				else pending.Push(i);
+			}
+			continue;
+		}
+		int res = SightPrecheck(q.looker, q.target, q.flags);
+		if (res < 0) pending.Push(i);
+		else q.result = !!res;
+	}
+
+	const unsigned numpending = pending.Size();
+	const unsigned numthreads = std::thread::hardware_concurrency();
+
+	// Not worth the overhead of waking the workers for a handful of traces.
+	if (numpending < 32 || numthreads < 2)
+	{
+		for (auto i : pending)
+		{
+			auto &q = queries[i];
+			q.result = SightTrace(MainSightContext, q.looker, q.target, q.flags);
+		}
+	}
+	else
+	{
+		static TArray<FSightContext> contexts;
+
+		const int numslices = (int)MIN(numthreads, numpending / 16);
+		const unsigned slicesize = (numpending + numslices - 1) / numslices;
+		if (contexts.Size() < (unsigned)numslices) contexts.Resize(numslices);
+
+		parallel_for(numslices, [&](int slice)
+		{
+			if (slice >= numslices) return;
+			auto &ctx = contexts[slice];
+			const unsigned first = slice * slicesize;
+			const unsigned last = MIN(first + slicesize, numpending);
+			for (unsigned j = first; j < last; j++)
+			{
+				auto &q = queries[pending[j]];
+				q.result = SightTrace(ctx, q.looker, q.target, q.flags);
+			}
+		});
+
+		for (int slice = 0; slice < numslices; slice++)
+		{
+			for (int j = 0; j < 6; j++)
+			{
+				MainSightContext.counts[j] += contexts[slice].counts[j];
+				contexts[slice].counts[j] = 0;
+			}
+			MainSightContext.cachehits += contexts[slice].cachehits;
+			MainSightContext.cachemisses += contexts[slice].cachemisses;
+			contexts[slice].cachehits = contexts[slice].cachemisses = 0;
+		}
+
+		// The workers only filled their own caches. Copy the results over so that P_CheckSight can find them.
+		if (sv_sightcache)
+		{
+			for (auto i : pending)
+			{
+				auto &q = queries[i];
+				*MainSightContext.FindCacheEntry(q.looker, q.target, q.flags) =
+					{ SightCacheEpoch, q.flags, q.looker->Level, q.looker->Pos(), q.target->Pos(), q.looker->Height, q.target->Height, q.result };
+			}
+		}
+	}
+
+	SightCycles.Unclock();
+}
+
+//==========================================================================
+//
+// P_PrimeSightCache
+//
+// Called before the monsters get ticked. Traces the sight checks that
+// monsters about to run their next state are most likely to make in
+// parallel and puts the results into the sight cache: chasers look at
+// their target the way P_CheckMissileRange does, idle monsters look at
+// the players like P_LookForPlayers. The actual checks still go through
+// P_CheckSight in the usual order with all their rejection tests and
+// RNG calls. They only use a cached trace if neither actor has moved
+// since, so the outcome is exactly the same as without this.
+//
+//==========================================================================
+
+void P_PrimeSightCache (FLevelLocals *Level)
+{
+	if (!sv_sightcache)
+	{
+		return;
+	}
+
+	static TArray<FSightQuery> queries;
+	queries.Clear();
+
+	auto it = Level->GetThinkerIterator<AActor>(NAME_None, STAT_DEFAULT);
+	AActor *actor;
+	while ((actor = it.Next()))
+	{
+		if (!(actor->flags3 & MF3_ISMONSTER) || actor->health <= 0 || (actor->flags2 & MF2_DORMANT) || actor->tics != 1)
+		{
+			continue;
+		}
+		AActor *target = actor->target;
+		if (target != nullptr)
+		{
+			queries.Push({ actor, target, SF_SEEPASTBLOCKEVERYTHING, false });
+		}
+		else
+		{
+			for (int i = 0; i < MAXPLAYERS; i++)
+			{
+				if (Level->PlayerInGame(i) && Level->Players[i]->mo != nullptr)
+				{
+					queries.Push({ actor, Level->Players[i]->mo, SF_SEEPASTSHOOTABLELINES, false });
+				}
+			}
+		}
+	}
+	P_CheckSightBatch(queries, true);
+}
+
 ADD_STAT (sight)
 {
 	FString out;
 	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d\n",
 		SightCycles.TimeMS(), MaxSightCycles.TimeMS(),
-		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5]);
+		MainSightContext.counts[3], MainSightContext.counts[0], MainSightContext.counts[1], MainSightContext.counts[2], MainSightContext.counts[4], MainSightContext.counts[5]);
+	return out;
+}
+
+ADD_STAT (sightcache)
+{
+	FString out;
+	int total = MainSightContext.cachehits + MainSightContext.cachemisses;
+	out.Format ("%s: %d hits, %d misses (%.1f%%), %d invalidations\n",
+		sv_sightcache ? "on" : "off", MainSightContext.cachehits, MainSightContext.cachemisses,
+		total > 0 ? MainSightContext.cachehits * 100. / total : 0., SightCacheInvalidations);
 	return out;
 }
 
+//==========================================================================
+//
+// P_InvalidateSightCache
+//
+// Must be called whenever something changes that can affect a sight
+// trace: moving planes, polyobjects, 3D floors and line flags.
+//
+//==========================================================================
+
+void P_InvalidateSightCache ()
+{
+	if (++SightCacheEpoch == INT_MAX) SightCacheEpoch = 1;
+	SightCacheInvalidations++;
+}
+
 void P_ResetSightCounters (bool full)
 {
 	if (full)
 	{
 		MaxSightCycles.Reset();
+		P_InvalidateSightCache();
 	}
 	if (SightCycles.Time() > MaxSightCycles.Time())
 	{
 		MaxSightCycles = SightCycles;
 	}
 	SightCycles.Reset();
-	memset (sightcounts, 0, sizeof(sightcounts));
+	memset (MainSightContext.counts, 0, sizeof(MainSightContext.counts));
+	MainSightContext.cachehits = MainSightContext.cachemisses = 0;
+	SightCacheInvalidations = 0;
 }
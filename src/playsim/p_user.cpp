@@ -150,6 +150,9 @@ static TArray<msecnode_t *> PredictionPortalSectors_sprev_Backup;
 static TArray<FLinePortal *> PredictionPortalLinesBackup;
 static TArray<portnode_t *> PredictionPortalLines_sprev_Backup;
 
+static TArray<FBlockActorEntry> PredictionBlockEntriesBackup;
+static TArray<int> PredictionBlockEntryPosBackup;
+
 // [GRB] Custom player classes
 TArray<FPlayerClass> PlayerClasses;
 
@@ -1446,6 +1449,8 @@ void P_PredictPlayer (player_t *player)
 	// without releasing them. (They will be used again in P_UnpredictPlayer).
 	FBlockNode *block = act->BlockNode;
 
+	PredictionBlockEntriesBackup.Clear();
+	PredictionBlockEntryPosBackup.Clear();
 	while (block != NULL)
 	{
 		if (block->NextActor != NULL)
@@ -1453,6 +1458,10 @@ void P_PredictPlayer (player_t *player)
 			block->NextActor->PrevActor = block->PrevActor;
 		}
 		*(block->PrevActor) = block->NextActor;
+
+		int pos = act->Level->blockmap.RemoveActorEntry(block->BlockIndex, act);
+		PredictionBlockEntryPosBackup.Push(pos);
+		PredictionBlockEntriesBackup.Push({ act, block->NextBlock != nullptr || block->PrevBlock != &act->BlockNode });
 		block = block->NextBlock;
 	}
 	act->BlockNode = NULL;
@@ -1588,6 +1597,7 @@ void P_UnPredictPlayer ()
 
 		// Now fix the pointers in the blocknode chain
 		FBlockNode *block = act->BlockNode;
+		TArray<int> blockindices;
 
 		while (block != NULL)
 		{
@@ -1596,9 +1606,17 @@ void P_UnPredictPlayer ()
 			{
 				block->NextActor->PrevActor = &block->NextActor;
 			}
+			blockindices.Push(block->BlockIndex);
 			block = block->NextBlock;
 		}
 
+		// Put the block entries back where they were, in reverse order of removal.
+		for (i = MIN(blockindices.Size(), PredictionBlockEntryPosBackup.Size()); i-- > 0;)
+		{
+			int pos = PredictionBlockEntryPosBackup[i];
+			if (pos >= 0) act->Level->blockmap.blockactors[blockindices[i]].Insert(pos, PredictionBlockEntriesBackup[i]);
+		}
+
 		actInvSel = InvSel;
 		player->inventorytics = inventorytics;
 	}
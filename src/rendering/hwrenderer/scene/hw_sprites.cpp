@@ -43,6 +43,7 @@
 #include "vectors.h"
 #include "texturemanager.h"
 #include "basics.h"
+#include "tflatmap.h"
 
 #include "hw_models.h"
 #include "hwrenderer/scene/hw_drawstructs.h"
@@ -1306,7 +1307,7 @@ void HWSprite::ProcessParticle (HWDrawInfo *di, particle_t *particle, sector_t *
 
 void HWDrawInfo::ProcessActorsInPortal(FLinePortalSpan *glport, area_t in_area)
 {
-	TMap<AActor*, bool> processcheck;
+	TFlatMap<AActor*, bool> processcheck;
 	if (glport->validcount == validcount) return;	// only process once per frame
 	glport->validcount = validcount;
     const auto &vp = Viewpoint;
@@ -84,6 +84,7 @@ class DoomSoundEngine : public SoundEngine
 	void CalcPosVel(int type, const void* source, const float pt[3], int channum, int chanflags, FSoundID soundid, FVector3* pos, FVector3* vel, FSoundChan *) override;
 	bool ValidatePosVel(int sourcetype, const void* source, const FVector3& pos, const FVector3& vel);
 	TArray<uint8_t> ReadSound(int lumpnum);
+	void PrefetchSound(int lumpnum) override;
 	int PickReplacement(int refid);
 	FSoundID ResolveSound(const void *ent, int type, FSoundID soundid, float &attenuation) override;
 	void CacheSound(sfxinfo_t* sfx) override;
@@ -371,6 +372,7 @@ void S_PrecacheLevel(FLevelLocals* Level)
 			soundEngine->MarkUsed(snd);
 		}
 		soundEngine->CacheMarkedSounds();
+		fileSystem.DropPrefetches();
 	}
 }
 
@@ -1214,6 +1216,11 @@ TArray<uint8_t> DoomSoundEngine::ReadSound(int lumpnum)
 	return wlump.Read();
 }
 
+void DoomSoundEngine::PrefetchSound(int lumpnum)
+{
+	fileSystem.PrefetchFile(lumpnum);
+}
+
 //==========================================================================
 //
 // S_PickReplacement